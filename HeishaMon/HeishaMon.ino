@@ -7,6 +7,7 @@
 #include <PubSubClient.h>
 #include <ESP8266WebServer.h>
 #include <ESP8266HTTPUpdateServer.h>
+#include <WebSocketsServer.h>
 #include <DNSServer.h>
 
 #include <ArduinoJson.h>
@@ -14,6 +15,15 @@
 #include "webfunctions.h"
 #include "decode.h"
 #include "commands.h"
+#include "frameparser.h"
+#include "commandqueue.h"
+#include "busscheduler.h"
+#include "responsetime.h"
+#include "serialstats.h"
+#include "metrics.h"
+#include "loopprofile.h"
+#include "heapstats.h"
+#include "logring.h"
 
 // maximum number of seconds between resets that
 // counts as a double reset
@@ -25,11 +35,17 @@
 #define DRD_ADDRESS 0x00
 
 
-#define SERIALTIMEOUT 2000 // wait until all 203 bytes are read, must not be too long to avoid blocking the code
 
 ESP8266WebServer httpServer(80);
 ESP8266HTTPUpdateServer httpUpdater;
 
+// pushes the changed values to the open web pages, instead of them polling /tablerefresh
+#define WEBSOCKETPORT 81
+#define WEBSOCKETMESSAGESIZE 512
+WebSocketsServer webSocket(WEBSOCKETPORT);
+unsigned long pushedDallasVersion = 0;
+unsigned long pushedS0Version = 0;
+
 settingsStruct heishamonSettings;
 
 bool sending = false; // mutex for sending data
@@ -38,6 +54,7 @@ unsigned long nexttime = 0;
 unsigned long allowreadtime = 0; //set to millis value during send, allow to wait millis for answer
 unsigned long goodreads = 0;
 unsigned long totalreads = 0;
+unsigned long skippedreads = 0; //good reads which were identical to the previous one, so not decoded
 float readpercentage = 0;
 
 // instead of passing array pointers between functions we just define this in the global scope
@@ -45,26 +62,36 @@ float readpercentage = 0;
 char data[MAXDATASIZE];
 byte  data_length = 0;
 
-// store actual data in an String array
-String actData[NUMBER_OF_TOPICS];
+// received serial bytes are collected and checked in here until a complete frame is found
+frameParserStruct serialParser;
+
+// store actual data as decoded fixed point values, see topicDescriptors[].type (TOPIC_TYPE_* in decode.h) for the format of each topic
+int32_t actData[NUMBER_OF_TOPICS];
 
 // log message to sprintf to
-char log_msg[256];
+char log_msg[LOGENTRYSIZE]; //the stats message is longer than 256, longer messages would be cut by the log ring anyway
 
-// mqtt topic to sprintf and then publish to
-char mqtt_topic[256];
+// log messages waiting for mqtt and serial1, and the recent history for the log page
+logRingStruct logRing;
 
 int mqttReconnects = 0;
 
-//buffer for commands to send
-struct command_struct {
-  byte value[128];
-  unsigned int length;
-  command_struct *next;
-};
-command_struct *commandBuffer;
-unsigned int commandsInBuffer = 0;
-#define MAXCOMMANDSINBUFFER 5 //can't have too much in buffer due to memory shortage
+//buffer for commands to send, in order of arrival
+commandQueueStruct commandBuffer;
+
+//decides what to send on the bus: buffered commands, optional pcb query or panasonic query
+busSchedulerStruct busScheduler;
+byte sendingTransaction = BUS_IDLE; //what is on the bus, BUS_COMMAND, BUS_OPTIONALPCB or BUS_POLL
+unsigned long sendtime = 0; //millis when it was sent
+
+//time until the answer is complete, for each type of transaction
+responseTimeStruct responseTimes[NUMBER_OF_BUS_TRANSACTIONS];
+
+//byte timing and outcome of the last transactions on the bus
+serialStatsStruct serialStats;
+
+//time spent in each stage of loop()
+loopProfileStruct loopProfile;
 
 
 //doule reset detection
@@ -74,6 +101,12 @@ DoubleResetDetect drd(DRD_TIMEOUT, DRD_ADDRESS);
 WiFiClient mqtt_wifi_client;
 PubSubClient mqtt_client(mqtt_wifi_client);
 
+// mqtt topic prefixes, rendered once after the settings are loaded
+mqttTopicStruct mqttTopicBase;   // <base>/
+mqttTopicStruct mqttTopicValues; // <base>/sdc/
+mqttTopicStruct mqttTopic1wire;  // <base>/1wire/
+mqttTopicStruct mqttTopicS0;     // <base>/s0/
+
 void mqtt_reconnect()
 {
   log_message((char*)"Reconnecting to mqtt server ...");
@@ -82,10 +115,10 @@ void mqtt_reconnect()
   if (mqtt_client.connect(heishamonSettings.wifi_hostname, heishamonSettings.mqtt_username, heishamonSettings.mqtt_password, topic, 1, true, "Offline"))
   {
     mqttReconnects++;
-    int arraysize = sizeof(commands) / sizeof(commands[0]), i = 0;
-
-    for (i = 0; i < arraysize; i++) {
-      sprintf(topic, "%s/%s", heishamonSettings.mqtt_topic_base, commands[i].name);
+    for (unsigned int i = 0; i < NUMBER_OF_COMMANDS; i++) {
+      char commandName[COMMAND_NAME_SIZE];
+      getCommandName(i, commandName);
+      sprintf(topic, "%s/%s", heishamonSettings.mqtt_topic_base, commandName);
       mqtt_client.subscribe(topic);
     }
 
@@ -101,15 +134,44 @@ void mqtt_reconnect()
 
 void log_message(char* string)
 {
-  if (heishamonSettings.logSerial1) Serial1.println(string);
-  if (heishamonSettings.logMqtt)
+  logRingAdd(&logRing, LOG_INFO, string);
+}
+
+void log_message_level(byte level, char* string)
+{
+  logRingAdd(&logRing, level, string);
+}
+
+// for the messages of each received value, these are published on their own topics already
+void log_debug(char* string)
+{
+  logRingAdd(&logRing, LOG_DEBUG, string);
+}
+
+void output_log_entry(logEntryStruct *entry)
+{
+  if (heishamonSettings.logSerial1) Serial1.println(entry->text);
+  if ((heishamonSettings.logMqtt) && (entry->level != LOG_DEBUG))
   {
-    char log_topic[256];
-    sprintf(log_topic, "%s/%s", heishamonSettings.mqtt_topic_base, mqtt_logtopic);
-    mqtt_client.publish(log_topic, string);
+    mqtt_client.publish(getMqttTopic(&mqttTopicBase, mqtt_logtopic), entry->text);
   }
 }
 
+// send a few log messages, only while no answer is expected so serial reception is not stalled
+void drain_log()
+{
+  if (sending) return;
+  logEntryStruct entry;
+  while (logRingDrain(&logRing, &entry)) output_log_entry(&entry);
+}
+
+// send all log messages now, before a reboot
+void flush_log()
+{
+  logEntryStruct entry;
+  while (logRingNext(&logRing, &entry)) output_log_entry(&entry);
+}
+
 void logHex(char *hex, byte hex_len) {
 #define LOGHEXBYTESPERLINE 32  // please be aware of max mqtt message size - 32 bytes per line does not work
   for (int i = 0; i < hex_len; i += LOGHEXBYTESPERLINE) {
@@ -132,115 +194,124 @@ byte calcChecksum(byte* command, int length) {
   return chk;
 }
 
-bool isValidReceiveChecksum() {
-  byte chk = 0;
-  for ( int i = 0; i < data_length; i++)  {
-    chk += data[i];
-  }
-  return (chk == 0); //all received bytes + checksum should result in 0
-}
-
 bool readSerial()
 {
-  if (data_length == 0 ) totalreads++; //this is the start of a new read
-
-  while ((Serial.available()) && (data_length < MAXDATASIZE)) {
-    data[data_length] = Serial.read(); //read available data and place it after the last received data
-    data_length++;
-    if (data[0] != 113) { //wrong header received!
-      log_message((char*)"Received bad header. Ignoring this data!");
-      if (heishamonSettings.logHexdump) logHex(data, data_length);
-      data_length = 0;
-      return false; //return so this while loop does not loop forever if there happens to be a continous invalid data stream
+  while (true) {
+    byte result = frameParserParse(&serialParser, data, &data_length);
+    if (result == FRAME_INCOMPLETE) {
+      if (!Serial.available()) return false;
+      serialStatsByte(&serialStats);
+      if (!frameParserPush(&serialParser, Serial.read())) {
+        serialStatsError(&serialStats, SERIAL_OUTCOME_OVERFLOW);
+        log_message_level(LOG_WARNING, (char*)"Serial receive buffer overflow, dropped oldest byte!");
+      }
+      continue;
+    }
+    if (result == FRAME_SKIPPED) {
+      serialStatsError(&serialStats, SERIAL_OUTCOME_BAD_HEADER);
+      log_message_level(LOG_WARNING, (char*)"Received bad header. Skipped data until next header.");
+      continue;
+    }
+    if (result == FRAME_BAD_LENGTH) {
+      serialStatsError(&serialStats, SERIAL_OUTCOME_BAD_HEADER);
+      log_message_level(LOG_WARNING, (char*)"Received invalid length in header! Searching for next header.");
+      continue;
+    }
+    if (result == FRAME_BAD_CHECKSUM) {
+      if (sending && !frameParserFirstHeader(&serialParser)) { //a false header found while resyncing, the answer may still be coming in
+        serialStatsError(&serialStats, SERIAL_OUTCOME_BAD_CHECKSUM);
+        log_message_level(LOG_WARNING, (char*)"Checksum received false after a false header! Searching for next header.");
+        continue;
+      }
+      log_message_level(LOG_WARNING, (char*)"Checksum received false! Searching for next header.");
+      serialStatsEnd(&serialStats, SERIAL_OUTCOME_BAD_CHECKSUM);
+      totalreads++;
+      sending = false; //we received an answer after our last command so from now on we can start a new send request again
+      continue;
     }
-  }
-
-  if (data_length > 1) { //should have received length part of header now
 
-    if ((data_length > (data[1] + 3)) || (data_length >= MAXDATASIZE) ) {
-      log_message((char*)"Received more data than header suggests! Ignoring this as this is bad data.");
-      if (heishamonSettings.logHexdump) logHex(data, data_length);
-      data_length = 0;
+    //FRAME_OK, we received a complete frame with a valid checksum
+    sprintf(log_msg, "Received %d bytes data", data_length); log_debug(log_msg);
+    if (sending) responseTimeAdd(&responseTimes[sendingTransaction], serialStatsLastByte(&serialStats)); //up to the last byte, not to when the loop got to parse the frame
+    serialStatsEnd(&serialStats, SERIAL_OUTCOME_OK);
+    sending = false; //we received an answer after our last command so from now on we can start a new send request again
+    if (heishamonSettings.logHexdump) logHex(data, data_length);
+    log_debug((char*)"Checksum and header received ok!");
+    totalreads++;
+    goodreads++;
+    readpercentage = (((float)goodreads / (float)totalreads) * 100);
+    sprintf(log_msg, "Total reads : %lu and total good reads : %lu (%.2f %%)", totalreads, goodreads, readpercentage ); log_debug(log_msg);
+    if (data_length == 203) { //for now only return true for this datagram because we can not decode the shorter datagram yet
+      return true;
+    }
+    else if (data_length == 20 ) { //optional pcb acknowledge answer
+      log_message((char*)"Received optional PCB ack answer, no need to decode this.");
       return false;
     }
-
-    if (data_length == (data[1] + 3)) { //we received all data (data[1] is header length field)
-      sprintf(log_msg, "Received %d bytes data", data_length); log_message(log_msg);
-      sending = false; //we received an answer after our last command so from now on we can start a new send request again
-      if (heishamonSettings.logHexdump) logHex(data, data_length);
-      if (! isValidReceiveChecksum() ) {
-        log_message((char*)"Checksum received false!");
-        data_length = 0; //for next attempt
-        return false;
-      }
-      log_message((char*)"Checksum and header received ok!");
-      goodreads++;
-      readpercentage = (((float)goodreads / (float)totalreads) * 100);
-      sprintf(log_msg, "Total reads : %lu and total good reads : %lu (%.2f %%)", totalreads, goodreads, readpercentage ); log_message(log_msg);
-      if (data_length == 203) { //for now only return true for this datagram because we can not decode the shorter datagram yet
-        data_length = 0;
-        return true;
-      }
-      else if (data_length == 20 ) { //optional pcb acknowledge answer
-        log_message((char*)"Received optional PCB ack answer, no need to decode this.");
-        data_length = 0;
-        return false;
-      }
-      else {
-        log_message((char*)"Received a shorter datagram. Can't decode this yet.");
-        data_length = 0;
-        return false;
-      }
+    else {
+      log_message((char*)"Received a shorter datagram. Can't decode this yet.");
+      return false;
     }
   }
-  return false;
 }
 
 void popCommandBuffer() {
-  if ((!sending) && (commandBuffer)) { //to make sure we can pop a command from the buffer
-    send_command(commandBuffer->value, commandBuffer->length);
-    command_struct* nextCommand = commandBuffer->next;
-    free(commandBuffer);
-    commandBuffer = nextCommand;
-    commandsInBuffer--;
+  if ((!sending) && commandQueueReady(&commandBuffer)) { //to make sure we can pop a command from the buffer
+    byte merged = commandQueueMerge(&commandBuffer);
+    if (merged > 0) {
+      sprintf(log_msg, "Merged %d buffered set commands into one frame, saved %lu bus transactions so far", merged + 1, commandBuffer.merged + commandBuffer.coalesced); log_message(log_msg);
+    }
+    commandStruct *command = commandQueuePeek(&commandBuffer);
+    write_command(command->value, command->length, BUS_COMMAND);
+    commandQueuePop(&commandBuffer);
   }
 }
 
-void pushCommandBuffer(byte* command, int length) {
-  if (commandsInBuffer < MAXCOMMANDSINBUFFER) {
-    command_struct* newCommand = new command_struct;
-    newCommand->length = length;
-    for (int i = 0 ; i < length ; i++) {
-      newCommand->value[i] = command[i];
-    }
-    newCommand->next = commandBuffer;
-    commandBuffer = newCommand;
-    commandsInBuffer++;
-  }
-  else {
-    log_message((char*)"Too much commands already in buffer. Ignoring this commands.");
+void pushCommandBuffer(byte* command, int length, byte key) {
+  switch (commandQueuePush(&commandBuffer, command, length, key)) {
+    case COMMANDQUEUE_COALESCED: {
+        log_message((char*)"Replaced the buffered command for the same setting with this one.");
+      } break;
+    case COMMANDQUEUE_FULL: {
+        log_message_level(LOG_WARNING, (char*)"Too much commands already in buffer. Ignoring this commands.");
+      } break;
+    case COMMANDQUEUE_TOOLARGE: {
+        log_message_level(LOG_WARNING, (char*)"Command too large to buffer. Ignoring this command.");
+      } break;
   }
 }
 
-bool send_command(byte* command, int length) {
-  if ( heishamonSettings.listenonly ) {
-    log_message((char*)"Not sending this command. Heishamon in listen only mode!");
-    return false;
-  }
-  if ( sending ) {
-    log_message((char*)"Already sending data. Buffering this send request");
-    pushCommandBuffer(command, length);
-    return false;
-  }
+void write_command(byte* command, int length, byte transaction) {
   sending = true; //simple semaphore to only allow one send command at a time, semaphore ends when answered data is received
 
   byte chk = calcChecksum(command, length);
   int bytesSent = Serial.write(command, length); //first send command
   bytesSent += Serial.write(chk); //then calculcated checksum byte afterwards
-  sprintf(log_msg, "sent bytes: %d including checksum value: %d ", bytesSent, int(chk)); log_message(log_msg);
+  sprintf(log_msg, "sent bytes: %d including checksum value: %d ", bytesSent, int(chk)); log_debug(log_msg);
 
   if (heishamonSettings.logHexdump) logHex((char*)command, length);
-  allowreadtime = millis() + SERIALTIMEOUT; //set allowreadtime when to timeout the answer of this command
+  sendingTransaction = transaction;
+  sendtime = millis();
+  serialStatsStart(&serialStats);
+  frameParserExpectAnswer(&serialParser);
+  allowreadtime = sendtime + responseTimes[transaction].timeout; //set allowreadtime when to timeout the answer of this command, based on the measured answer times
+}
+
+bool send_command(byte* command, int length, byte key) {
+  if ( heishamonSettings.listenonly ) {
+    log_message((char*)"Not sending this command. Heishamon in listen only mode!");
+    return false;
+  }
+  if ( sending || (commandBuffer.count > 0) ) { //commands already in the buffer go first to keep the order of arrival
+    log_message((char*)"Already sending data. Buffering this send request");
+    pushCommandBuffer(command, length, key);
+    return false;
+  }
+  if ( isSetCommand(command, length, key) ) { //wait a moment for other set commands to merge with
+    pushCommandBuffer(command, length, key);
+    return false;
+  }
+  write_command(command, length, BUS_COMMAND);
   return true;
 }
 
@@ -257,32 +328,26 @@ void mqtt_callback(char* topic, byte* payload, unsigned int length) {
     }
     msg[length] = '\0';
     char* topic_command = topic + strlen(heishamonSettings.mqtt_topic_base) + 1; //strip base plus seperator from topic
-    if (strcmp(topic_command, mqtt_send_raw_value_topic) == 0)
+    byte kind, index;
+    if (!findCommandTopic(topic_command, &kind, &index)) {
+      sprintf(log_msg, "Unknown command topic %s", topic_command); log_message(log_msg);
+    }
+    else if (kind == COMMAND_TOPIC_RAW)
     { // send a raw hex string
-      byte *rawcommand;
-      rawcommand = (byte *) malloc(length);
-      memcpy(rawcommand, msg, length);
-
       sprintf(log_msg, "sending raw value"); log_message(log_msg);
-      send_command(rawcommand, length);
-    } else if (strncmp(topic_command, mqtt_topic_pcb, 4) == 0)  // check for optional pcb commands
+      send_command((byte*)msg, length, COMMAND_KEY_NONE);
+    } else if (kind == COMMAND_TOPIC_PCB)  // optional pcb commands
     {
-      char* topic_pcb = &topic_command[4]; //strip the first 4 "pcb/" from the topic to get what we need
-      set_optionalpcb(topic_pcb, msg, log_message);
-    } else if (strncmp(topic_command, mqtt_topic_s0, 2) == 0)  // this is a s0 topic, check for watthour topic and restore it
+      set_optionalpcb(index, msg, log_message);
+    } else if (kind == COMMAND_TOPIC_S0)  // this is a s0 topic, restore the watthour of its port
     {
-      char* topic_s0_watthour_port = &topic_command[17]; //strip the first 17 "s0/WatthourTotal/" from the topic to get the s0 port
-      int s0Port = String(topic_s0_watthour_port).toInt();
       float watthour = String(msg).toFloat();
-      restore_s0_Watthour(s0Port, watthour);
+      restore_s0_Watthour(index, watthour);
       //unsubscribe after restoring the watthour values
-      char mqtt_topic[256];
-      sprintf(mqtt_topic, "%s", topic);
-      if (mqtt_client.unsubscribe(mqtt_topic)) log_message((char*)"Unsubscribed from S0 watthour restore topic");
+      if (mqtt_client.unsubscribe(topic)) log_message((char*)"Unsubscribed from S0 watthour restore topic");
     }
     else {
-      send_heatpump_command(topic_command, msg, send_command, log_message);
-
+      send_heatpump_command(index, msg, send_command, log_message);
     }
     mqttcallbackinprogress = false;
   }
@@ -311,10 +376,139 @@ void setupOTA() {
   ArduinoOTA.begin();
 }
 
+// Send the changed heatpump values to the web pages as [[topic,"value","description"],...], in messages
+// of at most WEBSOCKETMESSAGESIZE. For 1wire and s0 the page is told to reload the table.
+void push_changed_values() {
+  byte changed[(NUMBER_OF_TOPICS + 7) / 8];
+  bool anychanged = takeChangedTopics(changed);
+  if (webSocket.connectedClients() == 0) {
+    pushedDallasVersion = getDataVersion(DATA_DALLAS);
+    pushedS0Version = getDataVersion(DATA_S0);
+    return;
+  }
+  if (anychanged) {
+    char message[WEBSOCKETMESSAGESIZE];
+    char *end = message;
+    for (unsigned int topic = 0 ; topic < NUMBER_OF_TOPICS ; topic++) {
+      if (!(changed[topic >> 3] & (1 << (topic & 7)))) continue;
+      if ((end - message) + TOPIC_VALUE_TEXT_SIZE + TOPIC_DESCRIPTION_TEXT_SIZE + 20 > WEBSOCKETMESSAGESIZE) {
+        *end++ = ']';
+        webSocket.broadcastTXT(message, end - message);
+        end = message;
+      }
+      *end = (end == message) ? '[' : ',';
+      end++;
+      *end++ = '[';
+      end = formatUnsigned(topic, end);
+      end += strlen(strcpy(end, ",\""));
+      end += strlen(formatTopicValue(topic, actData[topic], end));
+      end += strlen(strcpy(end, "\",\""));
+      end += strlen(getTopicDescription(topic, actData[topic], end));
+      end += strlen(strcpy(end, "\"]"));
+    }
+    *end++ = ']';
+    webSocket.broadcastTXT(message, end - message);
+  }
+  if (pushedDallasVersion != getDataVersion(DATA_DALLAS)) {
+    pushedDallasVersion = getDataVersion(DATA_DALLAS);
+    webSocket.broadcastTXT("{\"reload\":\"1wire\"}");
+  }
+  if (pushedS0Version != getDataVersion(DATA_S0)) {
+    pushedS0Version = getDataVersion(DATA_S0);
+    webSocket.broadcastTXT("{\"reload\":\"s0\"}");
+  }
+}
+
+// all counters as Prometheus text, written in chunks from a fixed buffer
+void handleMetrics() {
+  static const char busTimeouts[] PROGMEM = "heishamon_bus_timeouts_total";
+  static const char logMessages[] PROGMEM = "heishamon_log_messages_total";
+  static const char heapStrings[] PROGMEM = "heishamon_heap_strings_total";
+  static const char heapBytes[] PROGMEM = "heishamon_heap_string_bytes_total";
+  static const char loopStageTime[] PROGMEM = "heishamon_loop_stage_microseconds";
+  static const char loopStageMax[] PROGMEM = "heishamon_loop_stage_max_microseconds";
+  static const char commands[] PROGMEM = "heishamon_commands_total";
+  static const char s0Pulses[] PROGMEM = "heishamon_s0_pulses_total";
+  static const char commandNames[][10] PROGMEM = { "queued", "coalesced", "merged", "dropped" };
+  static const char busNames[][12] PROGMEM = { "idle", "command", "optionalpcb", "poll" };
+  chunkWriterStruct writer;
+  char labels[32];
+
+  metricsBegin(&writer, &httpServer);
+  metricsSingle(&writer, PSTR("heishamon_uptime_seconds"), METRIC_COUNTER, PSTR("Seconds since boot"), millis() / 1000);
+  metricsSingle(&writer, PSTR("heishamon_reads_total"), METRIC_COUNTER, PSTR("Answers expected from the heatpump"), totalreads);
+  metricsSingle(&writer, PSTR("heishamon_good_reads_total"), METRIC_COUNTER, PSTR("Valid answers from the heatpump"), goodreads);
+  metricsSingle(&writer, PSTR("heishamon_skipped_reads_total"), METRIC_COUNTER, PSTR("Valid answers identical to the previous one"), skippedreads);
+  metricsSingle(&writer, PSTR("heishamon_mqtt_reconnects_total"), METRIC_COUNTER, PSTR("Reconnects to the mqtt server"), mqttReconnects);
+  metricsSingle(&writer, PSTR("heishamon_free_heap_bytes"), METRIC_GAUGE, PSTR("Free heap"), ESP.getFreeHeap());
+  metricsSingle(&writer, PSTR("heishamon_max_free_block_bytes"), METRIC_GAUGE, PSTR("Largest free heap block"), ESP.getMaxFreeBlockSize());
+  metricsSingle(&writer, PSTR("heishamon_heap_fragmentation_percent"), METRIC_GAUGE, PSTR("Heap fragmentation"), ESP.getHeapFragmentation());
+  metricsSingle(&writer, PSTR("heishamon_min_free_heap_bytes"), METRIC_GAUGE, PSTR("Lowest free heap since boot"), getHeapStats()->minFreeHeap);
+  metricsSingle(&writer, PSTR("heishamon_min_max_free_block_bytes"), METRIC_GAUGE, PSTR("Lowest largest free heap block since boot"), getHeapStats()->minMaxFreeBlock);
+  metricsFamily(&writer, heapStrings, METRIC_COUNTER, PSTR("Finished Strings built on the heap by each subsystem"));
+  for (byte i = 0 ; i < NUMBER_OF_HEAP_SITES ; i++) {
+    snprintf_P(labels, sizeof(labels), PSTR("site=\"%s\""), getHeapSiteName(i));
+    metricsValue(&writer, heapStrings, labels, getHeapStats()->sites[i].strings);
+  }
+  metricsFamily(&writer, heapBytes, METRIC_COUNTER, PSTR("Bytes of the Strings built on the heap by each subsystem"));
+  for (byte i = 0 ; i < NUMBER_OF_HEAP_SITES ; i++) {
+    snprintf_P(labels, sizeof(labels), PSTR("site=\"%s\""), getHeapSiteName(i));
+    metricsValue(&writer, heapBytes, labels, getHeapStats()->sites[i].bytes);
+  }
+  metricsSingle(&writer, PSTR("heishamon_loop_microseconds"), METRIC_GAUGE, PSTR("Duration of the last loop"), loopProfile.loopTime);
+  metricsSingle(&writer, PSTR("heishamon_loop_max_microseconds"), METRIC_GAUGE, PSTR("Longest loop since boot"), loopProfile.loopMaxTotal);
+  metricsSingle(&writer, PSTR("heishamon_loops_total"), METRIC_COUNTER, PSTR("Loops since boot"), loopProfile.loopsTotal);
+  metricsSingle(&writer, PSTR("heishamon_loops_per_second"), METRIC_GAUGE, PSTR("Loops per second in the last measurement window"), loopProfile.loopsPerSecond);
+  metricsFamily(&writer, loopStageTime, METRIC_GAUGE, PSTR("Time spent in each stage of the loop in the last measurement window"));
+  for (byte i = 0 ; i < NUMBER_OF_LOOP_STAGES ; i++) {
+    snprintf_P(labels, sizeof(labels), PSTR("stage=\"%s\""), getLoopStageName(i));
+    metricsValue(&writer, loopStageTime, labels, loopProfile.lastStages[i].time);
+  }
+  metricsFamily(&writer, loopStageMax, METRIC_GAUGE, PSTR("Longest run of each stage of the loop in the last measurement window"));
+  for (byte i = 0 ; i < NUMBER_OF_LOOP_STAGES ; i++) {
+    snprintf_P(labels, sizeof(labels), PSTR("stage=\"%s\""), getLoopStageName(i));
+    metricsValue(&writer, loopStageMax, labels, loopProfile.lastStages[i].max);
+  }
+  metricsFamily(&writer, commands, METRIC_COUNTER, PSTR("Commands by what happened to them in the buffer"));
+  unsigned long commandCounts[] = { commandBuffer.queued, commandBuffer.coalesced, commandBuffer.merged, commandBuffer.dropped };
+  for (byte i = 0 ; i < 4 ; i++) {
+    snprintf_P(labels, sizeof(labels), PSTR("result=\"%s\""), commandNames[i]);
+    metricsValue(&writer, commands, labels, commandCounts[i]);
+  }
+  metricsSingle(&writer, PSTR("heishamon_commands_buffered"), METRIC_GAUGE, PSTR("Commands waiting for the bus"), commandBuffer.count);
+  metricsSingleDecimal(&writer, PSTR("heishamon_bus_utilisation_percent"), METRIC_GAUGE, PSTR("Busy time of the bus in the last housekeeping period"), lrintf(busScheduler.utilisation * 100), 2);
+  metricsFamily(&writer, busTimeouts, METRIC_COUNTER, PSTR("Transactions without a complete answer"));
+  for (byte i = BUS_COMMAND ; i < NUMBER_OF_BUS_TRANSACTIONS ; i++) {
+    snprintf_P(labels, sizeof(labels), PSTR("transaction=\"%s\""), busNames[i]);
+    metricsValue(&writer, busTimeouts, labels, busScheduler.timeouts[i]);
+  }
+  metricsFamily(&writer, logMessages, METRIC_COUNTER, PSTR("Log messages by level"));
+  for (byte i = 0 ; i < NUMBER_OF_LOG_LEVELS ; i++) {
+    snprintf_P(labels, sizeof(labels), PSTR("level=\"%s\""), getLogLevelName(i));
+    metricsValue(&writer, logMessages, labels, logRing.logged[i]);
+  }
+  metricsSingle(&writer, PSTR("heishamon_log_dropped_total"), METRIC_COUNTER, PSTR("Log messages overwritten before they were sent"), logRing.dropped);
+  if (heishamonSettings.use_1wire) {
+    metricsSingle(&writer, PSTR("heishamon_dallas_errors_total"), METRIC_COUNTER, PSTR("Failed 1wire sensor reads"), getDallasErrors());
+  }
+  if (heishamonSettings.use_s0) {
+    metricsFamily(&writer, s0Pulses, METRIC_COUNTER, PSTR("Pulses counted on the s0 port"));
+    for (byte i = 0 ; i < NUM_S0_COUNTERS ; i++) {
+      metricsLabelValue(&writer, s0Pulses, PSTR("port"), i + 1, getS0PulsesTotal(i));
+    }
+  }
+  metricsEnd(&writer);
+}
+
 void setupHttp() {
+  static const char *headerKeys[] = { "If-None-Match" }; //for the ETag of /json, /values, /tablerefresh and the static files
+  httpServer.collectHeaders(headerKeys, 1);
   httpUpdater.setup(&httpServer, heishamonSettings.update_path, heishamonSettings.update_username, heishamonSettings.ota_password);
   httpServer.on("/", [] {
-    handleRoot(&httpServer, readpercentage, &heishamonSettings);
+    handleRoot(&httpServer, readpercentage, skippedreads, &heishamonSettings, &loopProfile);
+  });
+  httpServer.on("/heishamon.js", [] {
+    handleStatic(&httpServer);
   });
   httpServer.on("/command", [] {
     handleREST(&httpServer);
@@ -325,6 +519,24 @@ void setupHttp() {
   httpServer.on("/json", [] {
     handleJsonOutput(&httpServer, actData);
   });
+  httpServer.on("/meta", [] {
+    handleMeta(&httpServer);
+  });
+  httpServer.on("/values", [] {
+    handleValues(&httpServer, actData);
+  });
+  httpServer.on("/serialstats", [] {
+    handleSerialStats(&httpServer, &serialStats);
+  });
+  httpServer.on("/log", [] {
+    handleLog(&httpServer, &logRing);
+  });
+  httpServer.on("/heapstats", [] {
+    handleHeapStats(&httpServer);
+  });
+  httpServer.on("/metrics", [] {
+    handleMetrics();
+  });
   httpServer.on("/factoryreset", [] {
     handleFactoryReset(&httpServer);
   });
@@ -349,6 +561,7 @@ void setupHttp() {
     httpServer.client().stop();
   });
   httpServer.begin();
+  webSocket.begin();
 }
 
 void setupSerial() {
@@ -391,6 +604,10 @@ void switchSerial() {
 }
 
 void setupMqtt() {
+  setMqttTopicPrefix(&mqttTopicBase, heishamonSettings.mqtt_topic_base, 0);
+  setMqttTopicPrefix(&mqttTopicValues, heishamonSettings.mqtt_topic_base, mqtt_topic_values);
+  setMqttTopicPrefix(&mqttTopic1wire, heishamonSettings.mqtt_topic_base, mqtt_topic_1wire);
+  setMqttTopicPrefix(&mqttTopicS0, heishamonSettings.mqtt_topic_base, mqtt_topic_s0);
   mqtt_client.setBufferSize(1024);
   mqtt_client.setServer(heishamonSettings.mqtt_server, atoi(heishamonSettings.mqtt_port));
   mqtt_client.setCallback(mqtt_callback);
@@ -404,86 +621,140 @@ void setup() {
   setupSeria11();
   setupOTA();
   setupMqtt();
+  setTopicFilters(heishamonSettings.topicFilters, log_message);
   setupHttp();
   if (heishamonSettings.use_1wire) initDallasSensors(log_message, heishamonSettings.updataAllDallasTime, heishamonSettings.waitDallasTime);
-  if (heishamonSettings.use_s0) initS0Sensors(heishamonSettings.s0Settings, mqtt_client, heishamonSettings.mqtt_topic_base);
+  if (heishamonSettings.use_s0) initS0Sensors(heishamonSettings.s0Settings, mqtt_client, &mqttTopicS0);
   switchSerial();
+  busSchedulerInit(&busScheduler, 1000 * heishamonSettings.waitTime);
 }
 
 void send_panasonic_query() {
-  String message = "Requesting new panasonic data";
-  log_message((char*)message.c_str());
-  send_command(panasonicQuery, PANASONICQUERYSIZE);
+  log_debug((char*)"Requesting new panasonic data");
+  write_command(panasonicQuery, PANASONICQUERYSIZE, BUS_POLL); //the bus scheduler only sends it when the bus is free
 }
 
 void send_optionalpcb_query() {
-  String message = "Sending optional PCB data";
-  log_message((char*)message.c_str());
-  send_command(optionalPCBQuery, OPTIONALPCBQUERYSIZE);
+  log_debug((char*)"Sending optional PCB data");
+  write_command(optionalPCBQuery, OPTIONALPCBQUERYSIZE, BUS_OPTIONALPCB); //the bus scheduler only sends it when the bus is free
 }
 
 
 void read_panasonic_data() {
-  if (sending && (millis() > allowreadtime)) {
-    log_message((char*)"Previous read data attempt failed due to timeout!");
+  if (sending && (millis() > allowreadtime) && ((Serial.available() == 0) || (millis() - allowreadtime > RESPONSETIMEGRACE))) { //bytes which arrived while the loop was busy are read first, but noise on the line can not postpone the timeout forever
+    log_message_level(LOG_WARNING, (char*)"Previous read data attempt failed due to timeout!");
+    data_length = frameParserCopyPending(&serialParser, data, MAXDATASIZE);
+    if (data_length > 0) totalreads++; //a partial answer counts as a failed read
     sprintf(log_msg, "Received %d bytes data", data_length); log_message(log_msg);
     if (heishamonSettings.logHexdump) logHex(data, data_length);
-    data_length = 0; //clear any data in array
+    frameParserReset(&serialParser); //clear any data in the receive buffer
+    responseTimeTimeout(&responseTimes[sendingTransaction]);
+    serialStatsEnd(&serialStats, SERIAL_OUTCOME_TIMEOUT);
+    busSchedulerTimeout(&busScheduler, sendingTransaction);
     sending = false; //receiving the answer from the send command timed out, so we are allowed to send a new command
   }
-  if ( (heishamonSettings.listenonly || sending) && (Serial.available() > 0)) { //only read data if we have sent a command so we expect an answer or in listen only mode
+  if ( (heishamonSettings.listenonly || sending) && ((Serial.available() > 0) || (frameParserPending(&serialParser) > 0))) { //only read data if we have sent a command so we expect an answer or in listen only mode, bytes left from a previous read are parsed as well
     // read the serial and decode if data is complete and valid
-    if ( readSerial()) decode_heatpump_data(data, actData, mqtt_client, log_message, heishamonSettings.mqtt_topic_base, heishamonSettings.updateAllTime);
+    if ( readSerial()) {
+      if (heatpumpDataUnchanged(data)) {
+        skippedreads++;
+        sprintf(log_msg, "Received data identical to the previous data, skipped decoding (%lu skipped)", skippedreads); log_debug(log_msg);
+      } else {
+        decode_heatpump_data(data, actData, mqtt_client, log_debug, &mqttTopicValues, &mqttTopicBase, heishamonSettings.updateAllTime, heishamonSettings.mqttPublishTopics, heishamonSettings.mqttPublishJson);
+      }
+    }
   }
 }
 
 void loop() {
+  loopProfileStart(&loopProfile);
   // Handle OTA first.
   ArduinoOTA.handle();
+  loopProfileStage(&loopProfile, LOOP_STAGE_OTA);
   // then handle HTTP
   httpServer.handleClient();
+  webSocket.loop();
+  push_changed_values();
+  loopProfileStage(&loopProfile, LOOP_STAGE_HTTP);
   // Allow MDNS processing
   MDNS.update();
+  loopProfileStage(&loopProfile, LOOP_STAGE_MDNS);
 
   mqtt_client.loop();
+  loopProfileStage(&loopProfile, LOOP_STAGE_MQTT);
 
   read_panasonic_data();
-
-  if ((!sending) && (commandsInBuffer > 0)) { //check if there is a send command in the buffer
-    log_message((char *)"Sending command from buffer");
-    popCommandBuffer();
+  loopProfileStage(&loopProfile, LOOP_STAGE_SERIAL);
+
+  busSchedulerUpdate(&busScheduler, sending);
+  if ((!sending) && (!heishamonSettings.listenonly)) { //the bus is free, check what to send next
+    switch (busSchedulerNext(&busScheduler, commandBuffer.count > 0, commandQueueReady(&commandBuffer), heishamonSettings.optionalPCB)) {
+      case BUS_COMMAND: {
+          log_message((char *)"Sending command from buffer");
+          popCommandBuffer();
+        } break;
+      case BUS_OPTIONALPCB: {
+          send_optionalpcb_query();
+        } break;
+      case BUS_POLL: {
+          send_panasonic_query();
+        } break;
+    }
   }
 
-  if (heishamonSettings.use_1wire) dallasLoop(mqtt_client, log_message, heishamonSettings.mqtt_topic_base);
+  loopProfileStage(&loopProfile, LOOP_STAGE_BUS);
 
-  if (heishamonSettings.use_s0) s0Loop(mqtt_client, log_message, heishamonSettings.mqtt_topic_base, heishamonSettings.s0Settings);
+  if (heishamonSettings.use_1wire) dallasLoop(mqtt_client, log_message, &mqttTopic1wire);
+  loopProfileStage(&loopProfile, LOOP_STAGE_DALLAS);
 
+  if (heishamonSettings.use_s0) s0Loop(mqtt_client, log_message, &mqttTopicS0, heishamonSettings.s0Settings);
+  loopProfileStage(&loopProfile, LOOP_STAGE_S0);
 
-  // run the data query only each WAITTIME
-  if (millis() > nexttime) {
 
-    String message = "Heishamon stats: Uptime: " + getUptime() + " ## Free memory: " + getFreeMemory() + "% " + ESP.getFreeHeap() + " bytes ## Wifi: " + getWifiQuality() + "% ## Mqtt reconnects: " + mqttReconnects;
-    log_message((char*)message.c_str());
+  // run the housekeeping only each WAITTIME, but not more often than each 5 seconds
+  if (millis() > nexttime) {
+    snprintf(log_msg, sizeof(log_msg), "Heishamon stats: Uptime: %s ## Free memory: %d%% %u bytes ## Wifi: %d%% ## Mqtt reconnects: %d ## Bus transactions saved: %lu ## Bus utilisation: %.2f%% ## Optional PCB late: %lu ## Answer timeout: %lu ms ## Poll retries: %lu ## Loops per second: %lu ## Heap fragmentation: %u%% ## Min free heap: %u bytes",
+             getUptime().c_str(), getFreeMemory(), ESP.getFreeHeap(), getWifiQuality(), mqttReconnects, commandBuffer.merged + commandBuffer.coalesced, busSchedulerMeasure(&busScheduler), busScheduler.optionalPCBLate,
+             responseTimes[BUS_POLL].timeout, busScheduler.pollRetries, loopProfile.loopsPerSecond, ESP.getHeapFragmentation(), getHeapStats()->minFreeHeap);
+    log_message(log_msg);
     if (!mqtt_client.connected())
     {
       if (WiFi.status() != WL_CONNECTED) {
-        log_message((char *)"Lost WiFi connection, rebooting...");
+        log_message_level(LOG_ERROR, (char *)"Lost WiFi connection, rebooting...");
+        flush_log();
         delay(1000);
         ESP.restart();
       }
       if (! WiFi.localIP()) {
-        log_message((char *)"Lost IP configuration, rebooting...");
+        log_message_level(LOG_ERROR, (char *)"Lost IP configuration, rebooting...");
+        flush_log();
         delay(1000);
         ESP.restart();
       }
       mqtt_reconnect();
     }
-    nexttime = millis() + (1000 * heishamonSettings.waitTime);
-    if (!heishamonSettings.listenonly) send_panasonic_query();
-    if ((!heishamonSettings.listenonly) && (heishamonSettings.optionalPCB)) send_optionalpcb_query();
+    nexttime = millis() + (1000 * ((heishamonSettings.waitTime < 5) ? 5 : heishamonSettings.waitTime));
     MDNS.announce();
     //Make sure the LWT is set to Online, even if the broker have marked it dead.
-    sprintf(mqtt_topic, "%s/%s", heishamonSettings.mqtt_topic_base, mqtt_willtopic);
-    mqtt_client.publish(mqtt_topic, "Online");
+    mqtt_client.publish(getMqttTopic(&mqttTopicBase, mqtt_willtopic), "Online");
+    if (!heishamonSettings.listenonly) {
+      char json[SERIALSTATSJSONSIZE];
+      serialStatsJson(&serialStats, json, sizeof(json));
+      mqtt_client.publish(getMqttTopic(&mqttTopicBase, mqtt_topic_serialstats), json);
+    }
+    char loopJson[LOOPPROFILEJSONSIZE];
+    loopProfileJson(&loopProfile, loopJson, sizeof(loopJson));
+    mqtt_client.publish(getMqttTopic(&mqttTopicBase, mqtt_topic_loopstats), loopJson);
+    char heapJson[HEAPSTATSJSONSIZE];
+    heapStatsJson(heapJson, sizeof(heapJson));
+    mqtt_client.publish(getMqttTopic(&mqttTopicBase, mqtt_topic_heapstats), heapJson);
   }
+  heapStatsSample(false);
+  loopProfileStage(&loopProfile, LOOP_STAGE_HOUSEKEEPING);
+
+  drain_log();
+  loopProfileStage(&loopProfile, LOOP_STAGE_LOG);
+
+  loopProfileEnd(&loopProfile);
+  loopProfileMeasure(&loopProfile);
 }
@@ -0,0 +1,76 @@
+#include "busscheduler.h"
+
+// Decides what is sent next on the serial bus to the heatpump, only one request can be on the bus at a
+// time. Buffered user commands go first, so they don't wait behind the queries. The optional pcb query
+// is sent every OPTIONALPCBINTERVAL and goes before the buffered commands once it is half way to its
+// deadline, the other half is left for the request which is on the bus at that moment. The panasonic
+// query fills the time left, as soon as it is due.
+// The time the bus is in use is measured, so the poll interval can be lowered as long as there is
+// time left for commands.
+
+void busSchedulerInit(busSchedulerStruct *scheduler, unsigned long pollInterval) {
+  scheduler->pollInterval = pollInterval;
+  scheduler->nextPoll = millis();
+  scheduler->nextOptionalPCB = millis();
+  scheduler->measureStart = millis();
+}
+
+// Call every loop with the current sending state to measure the time the bus is in use
+void busSchedulerUpdate(busSchedulerStruct *scheduler, bool sending) {
+  if (sending && !scheduler->busy) {
+    scheduler->busy = true;
+    scheduler->busyStart = millis();
+  } else if (!sending && scheduler->busy) {
+    scheduler->busy = false;
+    scheduler->busyTime += millis() - scheduler->busyStart;
+  }
+}
+
+static bool busSchedulerDue(unsigned long time) {
+  return (long)(millis() - time) >= 0;
+}
+
+// What to send now the bus is free, the caller must send it
+byte busSchedulerNext(busSchedulerStruct *scheduler, bool commandsBuffered, bool commandReady, bool optionalPCB) {
+  byte next = BUS_IDLE;
+  if (optionalPCB && busSchedulerDue(scheduler->nextOptionalPCB + OPTIONALPCBDEADLINE / 2)) next = BUS_OPTIONALPCB;
+  else if (commandReady) next = BUS_COMMAND;
+  else if (commandsBuffered) next = BUS_IDLE; //wait for the buffered commands to be ready instead of starting a query
+  else if (optionalPCB && busSchedulerDue(scheduler->nextOptionalPCB)) next = BUS_OPTIONALPCB;
+  else if (busSchedulerDue(scheduler->nextPoll)) next = BUS_POLL;
+
+  if (next == BUS_OPTIONALPCB) {
+    if (busSchedulerDue(scheduler->nextOptionalPCB + OPTIONALPCBDEADLINE + 1)) scheduler->optionalPCBLate++;
+    scheduler->nextOptionalPCB = millis() + OPTIONALPCBINTERVAL;
+  } else if (next == BUS_POLL) {
+    scheduler->nextPoll = millis() + scheduler->pollInterval;
+    scheduler->pollIsRetry = scheduler->pollRetryPending;
+    scheduler->pollRetryPending = false;
+  }
+  if (next != BUS_IDLE) scheduler->transactions[next]++;
+  return next;
+}
+
+// The answer to a transaction did not arrive in time, a poll is retried once as soon as the bus is free
+void busSchedulerTimeout(busSchedulerStruct *scheduler, byte transaction) {
+  scheduler->timeouts[transaction]++;
+  if ((transaction == BUS_POLL) && !scheduler->pollIsRetry) {
+    scheduler->nextPoll = millis();
+    scheduler->pollRetryPending = true;
+    scheduler->pollRetries++;
+  }
+}
+
+// Percentage of time the bus was in use since the previous call
+float busSchedulerMeasure(busSchedulerStruct *scheduler) {
+  unsigned long busyTime = scheduler->busyTime;
+  if (scheduler->busy) {
+    busyTime += millis() - scheduler->busyStart;
+    scheduler->busyStart = millis();
+  }
+  unsigned long elapsed = millis() - scheduler->measureStart;
+  if (elapsed > 0) scheduler->utilisation = (100.0 * busyTime) / elapsed;
+  scheduler->busyTime = 0;
+  scheduler->measureStart = millis();
+  return scheduler->utilisation;
+}
@@ -0,0 +1,41 @@
+#ifndef BUSSCHEDULER_H
+#define BUSSCHEDULER_H
+
+#include <Arduino.h>
+
+#define OPTIONALPCBINTERVAL 5000 // millis between optional pcb queries, the heatpump expects them regularly
+#define OPTIONALPCBDEADLINE 2000 // millis an optional pcb query may be late, after half of it the query goes before buffered commands
+
+//results of busSchedulerNext, what to send on the bus
+#define BUS_IDLE 0
+#define BUS_COMMAND 1 // a buffered command
+#define BUS_OPTIONALPCB 2 // the optional pcb query
+#define BUS_POLL 3 // the panasonic query
+#define NUMBER_OF_BUS_TRANSACTIONS 4
+
+struct busSchedulerStruct {
+  unsigned long pollInterval = 5000; // millis between panasonic queries
+  unsigned long nextPoll = 0;
+  unsigned long nextOptionalPCB = 0;
+  bool busy = false;
+  unsigned long busyStart = 0;
+  bool pollRetryPending = false; // the next poll is a retry of a poll which timed out
+  bool pollIsRetry = false; // the poll on the bus is a retry, it is not retried again
+
+  //statistics
+  unsigned long busyTime = 0; // millis the bus was in use since measureStart
+  unsigned long measureStart = 0;
+  unsigned long transactions[NUMBER_OF_BUS_TRANSACTIONS] = { 0 };
+  unsigned long optionalPCBLate = 0; // optional pcb queries sent after their deadline
+  unsigned long timeouts[NUMBER_OF_BUS_TRANSACTIONS] = { 0 };
+  unsigned long pollRetries = 0;
+  float utilisation = 0; // percentage of time the bus was in use during the last measurement
+};
+
+void busSchedulerInit(busSchedulerStruct *scheduler, unsigned long pollInterval);
+void busSchedulerUpdate(busSchedulerStruct *scheduler, bool sending);
+byte busSchedulerNext(busSchedulerStruct *scheduler, bool commandsBuffered, bool commandReady, bool optionalPCB);
+void busSchedulerTimeout(busSchedulerStruct *scheduler, byte transaction);
+float busSchedulerMeasure(busSchedulerStruct *scheduler);
+
+#endif
@@ -0,0 +1,63 @@
+#include "chunkwriter.h"
+#include "publish.h"
+
+// The http responses which are generated (metrics, json) are written into a fixed buffer instead of
+// Strings, so the heap use of a request does not depend on the size of the response.
+
+void chunkBegin(chunkWriterStruct *writer, ESP8266WebServer *httpServer, const char *contentType) {
+  writer->httpServer = httpServer;
+  writer->length = 0;
+  httpServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  httpServer->send(200, contentType, "");
+}
+
+void chunkFlush(chunkWriterStruct *writer) {
+  if (writer->length == 0) return;
+  writer->httpServer->sendContent(writer->buffer, writer->length);
+  writer->length = 0;
+}
+
+// make room for at least size bytes
+static char *chunkReserve(chunkWriterStruct *writer, unsigned int size) {
+  if (writer->length + size > CHUNKBUFFERSIZE) chunkFlush(writer);
+  return &writer->buffer[writer->length];
+}
+
+void chunkAppend(chunkWriterStruct *writer, const char *text) {
+  unsigned int length = strlen(text);
+  if (length > CHUNKBUFFERSIZE) { //does not fit the buffer at all, send it as a chunk of its own
+    chunkFlush(writer);
+    writer->httpServer->sendContent(text, length);
+    return;
+  }
+  memcpy(chunkReserve(writer, length), text, length);
+  writer->length += length;
+}
+
+void chunkAppend_P(chunkWriterStruct *writer, PGM_P text) {
+  unsigned int length = strlen_P(text);
+  if (length > CHUNKBUFFERSIZE) {
+    chunkFlush(writer);
+    writer->httpServer->sendContent_P(text, length);
+    return;
+  }
+  memcpy_P(chunkReserve(writer, length), text, length);
+  writer->length += length;
+}
+
+void chunkAppendChar(chunkWriterStruct *writer, char c) {
+  *chunkReserve(writer, 1) = c;
+  writer->length++;
+}
+
+void chunkAppendUnsigned(chunkWriterStruct *writer, uint32_t value) {
+  char *end = formatUnsigned(value, chunkReserve(writer, 11)); // 10 digits and the terminator
+  writer->length = end - writer->buffer;
+}
+
+// Send what is left and end the response
+void chunkEnd(chunkWriterStruct *writer) {
+  chunkFlush(writer);
+  writer->httpServer->sendContent("");
+  writer->httpServer->client().stop();
+}
@@ -0,0 +1,23 @@
+#ifndef CHUNKWRITER_H
+#define CHUNKWRITER_H
+
+#include <ESP8266WebServer.h>
+
+#define CHUNKBUFFERSIZE 512 // the response is sent in chunks of at most this size
+
+// Collects a chunked http response in a fixed buffer, which is sent each time it is full
+struct chunkWriterStruct {
+  ESP8266WebServer *httpServer;
+  char buffer[CHUNKBUFFERSIZE];
+  unsigned int length = 0;
+};
+
+void chunkBegin(chunkWriterStruct *writer, ESP8266WebServer *httpServer, const char *contentType);
+void chunkAppend(chunkWriterStruct *writer, const char *text);
+void chunkAppend_P(chunkWriterStruct *writer, PGM_P text);
+void chunkAppendChar(chunkWriterStruct *writer, char c);
+void chunkAppendUnsigned(chunkWriterStruct *writer, uint32_t value);
+void chunkFlush(chunkWriterStruct *writer);
+void chunkEnd(chunkWriterStruct *writer);
+
+#endif
@@ -0,0 +1,109 @@
+#include "commandqueue.h"
+
+// FIFO ring buffer for commands which can't be sent yet because we are still waiting for the answer
+// of the previous command. Commands with the same key (the same setting) replace the queued one, so
+// only the latest value of a setting is written to the heatpump and the slow bus isn't spent on
+// stale writes. The replaced command keeps its place in the queue.
+//
+// Set commands are all the same 0xf1 0x6c 0x01 0x10 frame with only the bytes of the setting filled in,
+// a zero byte means no change. So set commands queued within COMMANDMERGEWINDOW millis are merged into
+// the oldest one and sent as a single frame with one checksum and one answer to wait for. Only commands
+// with non-zero bytes at different offsets are merged, settings sharing a byte (quiet and powerful mode,
+// heatpump and pump state) may encode other fields in that byte as well and are sent separately.
+
+static commandStruct *commandQueueAt(commandQueueStruct *queue, byte index) {
+  return &queue->commands[(queue->head + index) % COMMANDQUEUESIZE];
+}
+
+byte commandQueuePush(commandQueueStruct *queue, byte *command, unsigned int length, byte key) {
+  if (length > COMMANDMAXSIZE) {
+    queue->dropped++;
+    return COMMANDQUEUE_TOOLARGE;
+  }
+  commandStruct *entry = NULL;
+  byte result = COMMANDQUEUE_ADDED;
+  if (key != COMMAND_KEY_NONE) {
+    for (byte i = 0 ; i < queue->count ; i++) {
+      if (commandQueueAt(queue, i)->key == key) {
+        entry = commandQueueAt(queue, i);
+        result = COMMANDQUEUE_COALESCED;
+        queue->coalesced++;
+        break;
+      }
+    }
+  }
+  if (entry == NULL) {
+    if (queue->count == COMMANDQUEUESIZE) {
+      queue->dropped++;
+      return COMMANDQUEUE_FULL;
+    }
+    entry = commandQueueAt(queue, queue->count);
+    entry->time = millis();
+    queue->count++;
+    queue->queued++;
+  }
+  memcpy(entry->value, command, length);
+  entry->length = length;
+  entry->key = key;
+  return result;
+}
+
+// Oldest command or NULL if the queue is empty, it stays queued until commandQueuePop
+commandStruct *commandQueuePeek(commandQueueStruct *queue) {
+  if (queue->count == 0) return NULL;
+  return commandQueueAt(queue, 0);
+}
+
+void commandQueuePop(commandQueueStruct *queue) {
+  if (queue->count == 0) return;
+  queue->head = (queue->head + 1) % COMMANDQUEUESIZE;
+  queue->count--;
+}
+
+bool isSetCommand(byte *command, unsigned int length, byte key) {
+  return (key != COMMAND_KEY_NONE) && (length == SETCOMMANDSIZE) && (command[0] == 0xf1) && (command[1] == 0x6c) && (command[2] == 0x01) && (command[3] == 0x10);
+}
+
+// The oldest command can be sent, a set command waits for the merge window to pass
+bool commandQueueReady(commandQueueStruct *queue) {
+  commandStruct *command = commandQueuePeek(queue);
+  if (command == NULL) return false;
+  if (!isSetCommand(command->value, command->length, command->key)) return true;
+  return (unsigned long)(millis() - command->time) >= COMMANDMERGEWINDOW;
+}
+
+static bool setCommandsOverlap(commandStruct *a, commandStruct *b) {
+  for (byte i = 4 ; i < SETCOMMANDSIZE ; i++) {
+    if ((a->value[i] != 0) && (b->value[i] != 0)) return true;
+  }
+  return false;
+}
+
+// remove a command from the middle of the queue, the commands after it move up to keep the order
+static void commandQueueRemove(commandQueueStruct *queue, byte index) {
+  for (byte i = index ; i < queue->count - 1 ; i++) {
+    *commandQueueAt(queue, i) = *commandQueueAt(queue, i + 1);
+  }
+  queue->count--;
+}
+
+// Merge the set commands queued right after the oldest command into it if that is a set command, returns
+// the number of commands merged, so bus transactions saved. Merging stops at the first command which is
+// not a set command or which overlaps, so no command is sent before one which arrived earlier.
+byte commandQueueMerge(commandQueueStruct *queue) {
+  commandStruct *first = commandQueuePeek(queue);
+  if ((first == NULL) || !isSetCommand(first->value, first->length, first->key)) return 0;
+  byte merged = 0;
+  while (queue->count > 1) {
+    commandStruct *next = commandQueueAt(queue, 1);
+    if (!isSetCommand(next->value, next->length, next->key) || setCommandsOverlap(first, next)) break;
+    for (byte j = 4 ; j < SETCOMMANDSIZE ; j++) {
+      first->value[j] |= next->value[j];
+    }
+    commandQueueRemove(queue, 1);
+    merged++;
+  }
+  if (merged > 0) first->key = COMMAND_KEY_MERGED; //no longer a single setting, so nothing is coalesced into it anymore
+  queue->merged += merged;
+  return merged;
+}
@@ -0,0 +1,47 @@
+#ifndef COMMANDQUEUE_H
+#define COMMANDQUEUE_H
+
+#include <Arduino.h>
+
+#define COMMANDQUEUESIZE 8 // statically allocated, so keep it small due to memory shortage
+#define COMMANDMAXSIZE 128 // a set command is 110 bytes, larger raw commands are refused
+#define COMMANDMERGEWINDOW 200 // set commands wait this many millis in the queue so others arriving shortly after can be merged into the same frame
+#define SETCOMMANDSIZE 110 // 0xf1 0x6c 0x01 0x10 header, a zero byte means no change for that setting
+
+//keys of queued commands, set commands use their index in the commands[] table as key
+#define COMMAND_KEY_NONE 255 // never coalesced, for example raw commands
+#define COMMAND_KEY_MERGED 254 // set commands merged into one frame
+
+//results of commandQueuePush
+#define COMMANDQUEUE_ADDED 0 // added to the end of the queue
+#define COMMANDQUEUE_COALESCED 1 // replaced a queued command with the same key, keeping its place in the queue
+#define COMMANDQUEUE_FULL 2 // queue is full, command is dropped
+#define COMMANDQUEUE_TOOLARGE 3 // command does not fit COMMANDMAXSIZE, command is dropped
+
+struct commandStruct {
+  byte value[COMMANDMAXSIZE];
+  byte length = 0;
+  byte key = COMMAND_KEY_NONE;
+  unsigned long time = 0; // millis when it was queued
+};
+
+struct commandQueueStruct {
+  commandStruct commands[COMMANDQUEUESIZE];
+  byte head = 0; // oldest command
+  byte count = 0; // number of queued commands
+
+  //statistics
+  unsigned long queued = 0;
+  unsigned long coalesced = 0; // replaced by a newer command for the same setting, each one is a bus transaction saved
+  unsigned long merged = 0; // merged into the frame of another set command, each one is a bus transaction saved
+  unsigned long dropped = 0;
+};
+
+byte commandQueuePush(commandQueueStruct *queue, byte *command, unsigned int length, byte key);
+commandStruct *commandQueuePeek(commandQueueStruct *queue);
+void commandQueuePop(commandQueueStruct *queue);
+bool commandQueueReady(commandQueueStruct *queue);
+byte commandQueueMerge(commandQueueStruct *queue);
+bool isSetCommand(byte *command, unsigned int length, byte key);
+
+#endif
@@ -5,455 +5,275 @@ byte panasonicQuery[] = {0x71, 0x6c, 0x01, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0
 byte optionalPCBQuery[] = {0xF1, 0x11, 0x01, 0x50, 0x00, 0x00, 0x40, 0xFF, 0xFF, 0xE5, 0xFF, 0xFF, 0x00, 0xFF, 0xEB, 0xFF, 0xFF, 0x00, 0x00};
 
 
-const char* mqtt_topic_values = "sdc";
-const char* mqtt_topic_1wire = "1wire";
-const char* mqtt_topic_s0 = "s0";
-const char* mqtt_logtopic = "log";
-const char* mqtt_topic_pcb = "pcb/#";
-
-const char* mqtt_willtopic = "LWT";
-const char* mqtt_iptopic = "ip";
-
-const char* mqtt_send_raw_value_topic = "SendRawValue";
-
-unsigned int set_heatpump_state(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned  len = 0;
-  byte heatpump_state = 1;
-  String set_heatpump_state_string(msg);
-
-  if ( set_heatpump_state_string.toInt() == 1 ) {
-    heatpump_state = 2;
-  }
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set heatpump state to %d", heatpump_state);
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, heatpump_state, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
+// every set command starts with this header, followed by zero bytes up to SETCOMMANDSIZE
+static constexpr byte setCommandHeader[] PROGMEM = {0xf1, 0x6c, 0x01, 0x10};
+
+// byte values of commands which are not a simple calculation, indexed by the value minus the minimum value
+static constexpr byte HeatpumpStateBytes[] PROGMEM = {1, 2};
+static constexpr byte PumpStateBytes[] PROGMEM = {16, 32};
+static constexpr byte ForceDHWBytes[] PROGMEM = {64, 128};
+static constexpr byte ForceDefrostBytes[] PROGMEM = {0, 2};
+static constexpr byte ForceSterilizationBytes[] PROGMEM = {0, 4};
+static constexpr byte HolidayModeBytes[] PROGMEM = {16, 32};
+static constexpr byte OperationModeBytes[] PROGMEM = {18, 19, 24, 33, 34, 35, 40};
+
+static constexpr char HeatpumpStateLog[] PROGMEM = "set heatpump state to %d";
+static constexpr char PumpStateLog[] PROGMEM = "set pump state to %d";
+static constexpr char PumpSpeedLog[] PROGMEM = "set pump speed to %d";
+static constexpr char QuietModeLog[] PROGMEM = "set Quiet mode to %d";
+static constexpr char Z1HeatRequestLog[] PROGMEM = "set z1 heat request temperature to %d";
+static constexpr char Z1CoolRequestLog[] PROGMEM = "set z1 cool request temperature to %d";
+static constexpr char Z2HeatRequestLog[] PROGMEM = "set z2 heat request temperature to %d";
+static constexpr char Z2CoolRequestLog[] PROGMEM = "set z2 cool request temperature to %d";
+static constexpr char ForceDHWLog[] PROGMEM = "set force DHW mode to %d";
+static constexpr char ForceDefrostLog[] PROGMEM = "set force defrost mode to %d";
+static constexpr char ForceSterilizationLog[] PROGMEM = "set force sterilization mode to %d";
+static constexpr char HolidayModeLog[] PROGMEM = "set holiday mode to %d";
+static constexpr char PowerfulModeLog[] PROGMEM = "set powerful mode to %d";
+static constexpr char OperationModeLog[] PROGMEM = "set heat pump mode to %d";
+static constexpr char DHWTempLog[] PROGMEM = "set DHW temperature to %d";
+
+// everything needed to build a set command, the byte at offset is set to the value looked up in lookup,
+// or to (value + valueOffset) * scale when there is no lookup. Other bytes after the header stay zero
+// (no change), which is what allows merging set commands in the command buffer.
+struct commandDescriptorStruct {
+  char name[COMMAND_NAME_SIZE]; // mqtt topic and REST argument
+  byte offset;                  // byte of the setting in the set command
+  int16_t minValue;             // valid range of the value
+  int16_t maxValue;
+  int16_t valueOffset;
+  byte scale;
+  const byte *lookup;
+  const char *logFormat;        // log message, %d is the value
+};
+
+static constexpr commandDescriptorStruct commandDescriptors[NUMBER_OF_COMMANDS] PROGMEM = {
+  //name                           byte  min  max  offset scale lookup                    log
+  { "SetHeatpump",                 4,    0,   1,   0,     1,    HeatpumpStateBytes,       HeatpumpStateLog       }, // set heatpump state to on by sending 1
+  { "SetPump",                     4,    0,   1,   0,     1,    PumpStateBytes,           PumpStateLog           }, // set pump state to on by sending 1
+  { "SetPumpSpeed",                45,   64,  254, 1,     1,    0,                        PumpSpeedLog           }, // set pump speed
+  { "SetQuietMode",                7,    0,   3,   1,     8,    0,                        QuietModeLog           }, // set 0 for Off mode, set 1 for Quiet mode 1, set 2 for Quiet mode 2, set 3 for Quiet mode 3
+  { "SetZ1HeatRequestTemperature", 38,   -5,  75,  128,   1,    0,                        Z1HeatRequestLog       }, // z1 heat request temp -  set from -5 to 5 to get same temperature shift point or set direct temp
+  { "SetZ1CoolRequestTemperature", 39,   -5,  75,  128,   1,    0,                        Z1CoolRequestLog       }, // z1 cool request temp -  set from -5 to 5 to get same temperature shift point or set direct temp
+  { "SetZ2HeatRequestTemperature", 40,   -5,  75,  128,   1,    0,                        Z2HeatRequestLog       }, // z2 heat request temp -  set from -5 to 5 to get same temperature shift point or set direct temp
+  { "SetZ2CoolRequestTemperature", 41,   -5,  75,  128,   1,    0,                        Z2CoolRequestLog       }, // z2 cool request temp -  set from -5 to 5 to get same temperature shift point or set direct temp
+  { "SetForceDHW",                 4,    0,   1,   0,     1,    ForceDHWBytes,            ForceDHWLog            }, // set mode to force DHW by sending 1
+  { "SetForceDefrost",             8,    0,   1,   0,     1,    ForceDefrostBytes,        ForceDefrostLog        }, // set mode to force defrost  by sending 1
+  { "SetForceSterilization",       8,    0,   1,   0,     1,    ForceSterilizationBytes,  ForceSterilizationLog  }, // set mode to force sterilization by sending 1
+  { "SetHolidayMode",              5,    0,   1,   0,     1,    HolidayModeBytes,         HolidayModeLog         }, // set Holiday mode by sending 1, off will be 0
+  { "SetPowerfulMode",             7,    0,   3,   73,    1,    0,                        PowerfulModeLog        }, // set Powerful mode by sending 0 = off, 1 for 30min, 2 for 60min, 3 for 90 min
+  { "SetOperationMode",            6,    0,   6,   0,     1,    OperationModeBytes,       OperationModeLog       }, // set Heat pump operation mode  3 = DHW only, 0 = heat only, 1 = cool only, 2 = Auto, 4 = Heat+DHW, 5 = Cool+DHW, 6 = Auto + DHW
+  { "SetDHWTemp",                  42,   40,  75,  128,   1,    0,                        DHWTempLog             }, // set DHW temperature by sending desired temperature between 40C-75C
+};
+
+// the encoded value must fit in a byte for the whole range
+static constexpr bool commandDescriptorValid(const commandDescriptorStruct &command) {
+  return (command.offset >= sizeof(setCommandHeader)) && (command.offset < SETCOMMANDSIZE) && (command.minValue <= command.maxValue) &&
+         (command.lookup ? true : (((command.minValue + command.valueOffset) * command.scale >= 0) && ((command.maxValue + command.valueOffset) * command.scale <= 255)));
 }
 
-unsigned int set_pump(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_pump_string(msg);
-
-  byte pump_state = 16;
-  if ( set_pump_string.toInt() == 1 ) {
-    pump_state = 32;
-  }
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set pump state to %d", pump_state);
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, pump_state, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
+static constexpr bool commandDescriptorsValid(unsigned int command = 0) {
+  return (command == NUMBER_OF_COMMANDS) || (commandDescriptorValid(commandDescriptors[command]) && commandDescriptorsValid(command + 1));
 }
 
-unsigned int set_pump_speed(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_pumpspeed_string(msg);
-
-  byte pumpspeed = set_pumpspeed_string.toInt() + 1;
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set pump speed to %d", pumpspeed - 1);
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, pumpspeed, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
+static_assert(sizeof(commandDescriptors) / sizeof(commandDescriptors[0]) == NUMBER_OF_COMMANDS, "commandDescriptors must have NUMBER_OF_COMMANDS entries");
+static_assert(commandDescriptorsValid(), "commandDescriptors has an entry with a wrong offset or range");
+static_assert(sizeof(OperationModeBytes) == 7, "SetOperationMode accepts 7 operating modes");
+
+constexpr commandTopicStruct commandTopics[NUMBER_OF_COMMAND_TOPICS] PROGMEM = {
+  //name                                kind                index
+  { "SendRawValue",                      COMMAND_TOPIC_RAW,   0 },
+  { "SetDHWTemp",                        COMMAND_TOPIC_SET,  14 },
+  { "SetForceDHW",                       COMMAND_TOPIC_SET,   8 },
+  { "SetForceDefrost",                   COMMAND_TOPIC_SET,   9 },
+  { "SetForceSterilization",             COMMAND_TOPIC_SET,  10 },
+  { "SetHeatpump",                       COMMAND_TOPIC_SET,   0 },
+  { "SetHolidayMode",                    COMMAND_TOPIC_SET,  11 },
+  { "SetOperationMode",                  COMMAND_TOPIC_SET,  13 },
+  { "SetPowerfulMode",                   COMMAND_TOPIC_SET,  12 },
+  { "SetPump",                           COMMAND_TOPIC_SET,   1 },
+  { "SetPumpSpeed",                      COMMAND_TOPIC_SET,   2 },
+  { "SetQuietMode",                      COMMAND_TOPIC_SET,   3 },
+  { "SetZ1CoolRequestTemperature",       COMMAND_TOPIC_SET,   5 },
+  { "SetZ1HeatRequestTemperature",       COMMAND_TOPIC_SET,   4 },
+  { "SetZ2CoolRequestTemperature",       COMMAND_TOPIC_SET,   7 },
+  { "SetZ2HeatRequestTemperature",       COMMAND_TOPIC_SET,   6 },
+  { "pcb/Buffer_Temp",                   COMMAND_TOPIC_PCB,   7 },
+  { "pcb/Compressor_State",              COMMAND_TOPIC_PCB,   1 },
+  { "pcb/Demand_Control",                COMMAND_TOPIC_PCB,   5 },
+  { "pcb/External_Thermostat_1_State",   COMMAND_TOPIC_PCB,   3 },
+  { "pcb/External_Thermostat_2_State",   COMMAND_TOPIC_PCB,   4 },
+  { "pcb/Heat_Cool_Mode",                COMMAND_TOPIC_PCB,   0 },
+  { "pcb/Pool_Temp",                     COMMAND_TOPIC_PCB,   6 },
+  { "pcb/SmartGrid_Mode",                COMMAND_TOPIC_PCB,   2 },
+  { "pcb/Solar_Temp",                    COMMAND_TOPIC_PCB,  12 },
+  { "pcb/Z1_Room_Temp",                  COMMAND_TOPIC_PCB,   8 },
+  { "pcb/Z1_Water_Temp",                 COMMAND_TOPIC_PCB,   9 },
+  { "pcb/Z2_Room_Temp",                  COMMAND_TOPIC_PCB,  10 },
+  { "pcb/Z2_Water_Temp",                 COMMAND_TOPIC_PCB,  11 },
+  { "s0/WatthourTotal/1",                COMMAND_TOPIC_S0,    1 },
+  { "s0/WatthourTotal/2",                COMMAND_TOPIC_S0,    2 },
+};
+
+static constexpr int commandStrcmp(const char *a, const char *b) {
+  return ((*a != *b) || (*a == '\0')) ? ((byte)*a - (byte)*b) : commandStrcmp(a + 1, b + 1);
 }
 
-unsigned int set_quiet_mode(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_quiet_mode_string(msg);
-
-  byte quiet_mode = (set_quiet_mode_string.toInt() + 1) * 8;
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set Quiet mode to %d", quiet_mode / 8 - 1);
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, 0x00, 0x00, quiet_mode, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
+// a command topic must be sorted and match the name of the command or optional pcb topic it is for
+static constexpr bool commandTopicValid(unsigned int topic) {
+  return ((topic == 0) || (commandStrcmp(commandTopics[topic - 1].name, commandTopics[topic].name) < 0)) &&
+         ((commandTopics[topic].kind != COMMAND_TOPIC_SET) || (commandStrcmp(commandTopics[topic].name, commandDescriptors[commandTopics[topic].index].name) == 0)) &&
+         ((commandTopics[topic].kind != COMMAND_TOPIC_PCB) || (commandStrcmp(commandTopics[topic].name + 4, optionalPcbTopics[commandTopics[topic].index]) == 0)) &&
+         ((commandTopics[topic].kind != COMMAND_TOPIC_S0) || ((commandTopics[topic].index >= 1) && (commandTopics[topic].index <= NUM_S0_COUNTERS)));
 }
 
-unsigned int set_z1_heat_request_temperature(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_temperature_string(msg);
-
-  byte request_temp = set_temperature_string.toInt() + 128;
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set z1 heat request temperature to %d", request_temp - 128 );
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, request_temp, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
+static constexpr bool commandTopicsValid(unsigned int topic = 0) {
+  return (topic == NUMBER_OF_COMMAND_TOPICS) || (commandTopicValid(topic) && commandTopicsValid(topic + 1));
 }
 
-unsigned int set_z1_cool_request_temperature(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_temperature_string(msg);
-
-  byte request_temp = set_temperature_string.toInt() + 128;
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set z1 cool request temperature to %d", request_temp - 128 );
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
+static_assert(sizeof(commandTopics) / sizeof(commandTopics[0]) == NUMBER_OF_COMMAND_TOPICS, "commandTopics must have NUMBER_OF_COMMAND_TOPICS entries");
+static_assert(NUMBER_OF_COMMAND_TOPICS == NUMBER_OF_COMMANDS + NUMBER_OF_OPTIONALPCB_TOPICS + 1 + NUM_S0_COUNTERS, "commandTopics must have every command, optional pcb topic, the raw topic and the s0 topics");
+static_assert(commandTopicsValid(), "commandTopics is not sorted or has an entry which does not match its command or optional pcb topic");
 
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, request_temp, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
-}
 
-unsigned int set_z2_heat_request_temperature(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_temperature_string(msg);
-
-  byte request_temp = set_temperature_string.toInt() + 128;
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set z2 heat request temperature to %d", request_temp - 128 );
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, request_temp, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
-}
-
-unsigned int set_z2_cool_request_temperature(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_temperature_string(msg);
-
-  byte request_temp = set_temperature_string.toInt() + 128;
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set z2 cool request temperature to %d", request_temp - 128 );
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, request_temp, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
-}
-
-unsigned int set_force_DHW(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_force_DHW_string(msg);
-
-  byte force_DHW_mode = 64; //hex 0x40
-  if ( set_force_DHW_string.toInt() == 1 ) {
-    force_DHW_mode = 128; //hex 0x80
-  }
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set force DHW mode to %d", force_DHW_mode);
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, force_DHW_mode, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
-}
-
-unsigned int set_force_defrost(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_force_defrost_string(msg);
-
-  byte force_defrost_mode = 0;
-  if ( set_force_defrost_string.toInt() == 1 ) {
-    force_defrost_mode = 2; //hex 0x02
-  }
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set force defrost mode to %d", force_defrost_mode);
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
+const char* mqtt_topic_values = "sdc";
+const char* mqtt_topic_json = "json";
+const char* mqtt_topic_1wire = "1wire";
+const char* mqtt_topic_s0 = "s0";
+const char* mqtt_logtopic = "log";
+const char* mqtt_topic_serialstats = "serialstats";
+const char* mqtt_topic_loopstats = "loopstats";
+const char* mqtt_topic_heapstats = "heapstats";
+const char* mqtt_topic_pcb = "pcb/#";
 
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, 0x00, 0x00, 0x00, force_defrost_mode, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+const char* mqtt_willtopic = "LWT";
+const char* mqtt_iptopic = "ip";
 
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
 
-  return len;
+// Build the set command of commandDescriptors[command] for the value in msg, returns the command length or 0 when
+// the value is out of range. cmd must hold SETCOMMANDSIZE bytes and log_msg COMMAND_LOG_SIZE chars.
+unsigned int encodeCommand(unsigned int command, char *msg, byte *cmd, char *log_msg) {
+  char name[COMMAND_NAME_SIZE];
+  strcpy_P(name, commandDescriptors[command].name);
+  int value = atoi(msg);
+  int minValue = (int16_t)pgm_read_word(&commandDescriptors[command].minValue);
+  int maxValue = (int16_t)pgm_read_word(&commandDescriptors[command].maxValue);
+  if ((value < minValue) || (value > maxValue)) {
+    snprintf(log_msg, COMMAND_LOG_SIZE, "%s value %d out of range %d to %d, ignoring this command", name, value, minValue, maxValue);
+    return 0;
+  }
+
+  byte encoded;
+  const byte *lookup = (const byte *)pgm_read_ptr(&commandDescriptors[command].lookup);
+  if (lookup) {
+    encoded = pgm_read_byte(lookup + value - minValue);
+  } else {
+    encoded = (value + (int16_t)pgm_read_word(&commandDescriptors[command].valueOffset)) * pgm_read_byte(&commandDescriptors[command].scale);
+  }
+
+  memcpy_P(cmd, setCommandHeader, sizeof(setCommandHeader));
+  memset(cmd + sizeof(setCommandHeader), 0, SETCOMMANDSIZE - sizeof(setCommandHeader));
+  cmd[pgm_read_byte(&commandDescriptors[command].offset)] = encoded;
+  snprintf_P(log_msg, COMMAND_LOG_SIZE, (const char *)pgm_read_ptr(&commandDescriptors[command].logFormat), value);
+  return SETCOMMANDSIZE;
 }
 
-unsigned int set_force_sterilization(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_force_sterilization_string(msg);
-
-  byte force_sterilization_mode = 0;
-  if ( set_force_sterilization_string.toInt() == 1 ) {
-    force_sterilization_mode = 4; //hex 0x04
-  }
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set force sterilization mode to %d", force_sterilization_mode);
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, 0x00, 0x00, 0x00, force_sterilization_mode, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
+// Binary search of the command topics, returns false if name is not a command topic
+bool findCommandTopic(const char *name, byte *kind, byte *index) {
+  int first = 0;
+  int last = NUMBER_OF_COMMAND_TOPICS - 1;
+  while (first <= last) {
+    int middle = (first + last) / 2;
+    int compare = strcmp_P(name, commandTopics[middle].name);
+    if (compare == 0) {
+      *kind = pgm_read_byte(&commandTopics[middle].kind);
+      *index = pgm_read_byte(&commandTopics[middle].index);
+      return true;
+    }
+    if (compare < 0) last = middle - 1;
+    else first = middle + 1;
   }
-
-  return len;
+  return false;
 }
 
-unsigned int set_holiday_mode(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_holiday_string(msg);
-
-  byte set_holiday = 16; //hex 0x10
-  if ( set_holiday_string.toInt() == 1 ) {
-    set_holiday = 32; //hex 0x20
-  }
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set holiday mode to %d", set_holiday);
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, set_holiday, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
+// commandDescriptors index of a command name or -1 if it is not a heatpump command
+int findCommand(const char *name) {
+  byte kind, index;
+  if (findCommandTopic(name, &kind, &index) && (kind == COMMAND_TOPIC_SET)) return index;
+  return -1;
 }
 
-unsigned int set_powerful_mode(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_powerful_string(msg);
-
-  byte set_powerful = (set_powerful_string.toInt() ) + 73;
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set powerful mode to %d", (set_powerful - 73) );
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, 0x00, 0x00, set_powerful, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
+void getCommandName(unsigned int command, char *buffer) {
+  strcpy_P(buffer, commandDescriptors[command].name);
 }
 
-unsigned int set_DHW_temp(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_DHW_temp_string(msg);
-
-  byte set_DHW_temp = set_DHW_temp_string.toInt() + 128;
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set DHW temperature to %d", set_DHW_temp - 128);
-    memcpy(*log_msg, tmp, sizeof(tmp));
-  }
-
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, set_DHW_temp, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
-  }
-
-  return len;
+void send_heatpump_command(unsigned int command, char *msg, bool (*send_command)(byte*, int, byte), void (*log_message)(char*)) {
+  byte cmd[SETCOMMANDSIZE];
+  char log_msg[COMMAND_LOG_SIZE];
+  unsigned int len = encodeCommand(command, msg, cmd, log_msg);
+  log_message(log_msg);
+  if (len > 0) send_command(cmd, len, command); //the index is the key to replace a buffered command for the same setting
 }
 
-unsigned int set_operation_mode(char *msg, unsigned char **cmd, char **log_msg) {
-  unsigned int len = 0;
-  String set_mode_string(msg);
-  byte set_mode;
-  switch (set_mode_string.toInt()) {
-    case 0: set_mode = 18; break;
-    case 1: set_mode = 19; break;
-    case 2: set_mode = 24; break;
-    case 3: set_mode = 33; break;
-    case 4: set_mode = 34; break;
-    case 5: set_mode = 35; break;
-    case 6: set_mode = 40; break;
-    default: set_mode = 0; break;
-  }
-
-  {
-    char tmp[256] = { 0 };
-    snprintf(tmp, 255, "set heat pump mode to %d", set_mode);
-    memcpy(*log_msg, tmp, sizeof(tmp));
+void set_optionalpcb(unsigned int pcbTopic, char *msg, void (*log_message)(char*)) {
+  char log_msg[256];
+  String set_pcb_string(msg);
+  if (pcbTopic >= OPTIONALPCB_FIRST_TEMP) {
+    float temp = set_pcb_string.toFloat();
+    float hextemp;
+    if (temp > 120) {
+      hextemp = 0;
+    } else if (temp < -78) {
+      hextemp = 255;
+    }
+    else {
+      byte Uref = 255;
+      int constant = 3695;
+      int R25 = 6340;
+      byte T25 = 25;
+      int Rf = 6480;
+      float K = 273.15;
+      float RT = R25 * exp(constant * (1 / (temp + K) - 1 / (T25 + K)));
+      hextemp = Uref * (RT / (Rf + RT));
+    }
+    optionalPCBQuery[optionalPcbBytes[pcbTopic]] = (int)hextemp;
+    sprintf(log_msg, "set optional pcb %s to temp %.2f, hextemp DEC %.2f = HEX %x", optionalPcbTopics[pcbTopic], temp, hextemp, (int)hextemp); log_message(log_msg);
+  }
+  else if (pcbTopic == OPTIONALPCB_HEAT_COOL_MODE) {
+    bool set_pcb_value = (set_pcb_string.toInt() == 1);
+    optionalPCBQuery[optionalPcbBytes[pcbTopic]] = (optionalPCBQuery[optionalPcbBytes[pcbTopic]] & ~(0b1 << 7)) | ( set_pcb_value << 7 );
+    sprintf(log_msg, "set optional pcb %s to %d", optionalPcbTopics[pcbTopic], set_pcb_value); log_message(log_msg);
+  }
+  else if (pcbTopic == OPTIONALPCB_COMPRESSOR_STATE) {
+    bool set_pcb_value = (set_pcb_string.toInt() == 1);
+    optionalPCBQuery[optionalPcbBytes[pcbTopic]] = (optionalPCBQuery[optionalPcbBytes[pcbTopic]] & ~(0b1 << 6)) | ( set_pcb_value << 6 );
+    sprintf(log_msg, "set optional pcb %s to %d", optionalPcbTopics[pcbTopic], set_pcb_value); log_message(log_msg);
+  }
+  else if (pcbTopic == OPTIONALPCB_SMARTGRID_MODE) {
+    byte set_pcb_value = set_pcb_string.toInt();
+    if (set_pcb_value < 4) {
+      optionalPCBQuery[optionalPcbBytes[pcbTopic]] = (optionalPCBQuery[optionalPcbBytes[pcbTopic]] & ~(0b11 << 4)) | ( set_pcb_value << 4 );
+      sprintf(log_msg, "set optional pcb %s to %d", optionalPcbTopics[pcbTopic], set_pcb_value); log_message(log_msg);
+    }
   }
+  else if (pcbTopic == OPTIONALPCB_EXTERNAL_THERMOSTAT_1_STATE) {
+    byte set_pcb_value = set_pcb_string.toInt();
+    if (set_pcb_value < 4) {
+      optionalPCBQuery[optionalPcbBytes[pcbTopic]] = (optionalPCBQuery[optionalPcbBytes[pcbTopic]] & ~(0b11 << 2)) | ( set_pcb_value << 2 );
+      sprintf(log_msg, "set optional pcb %s to %d", optionalPcbTopics[pcbTopic], set_pcb_value); log_message(log_msg);
+    }
 
-  {
-    unsigned char tmp[] = {0xf1, 0x6c, 0x01, 0x10, 0x00, 0x00, set_mode, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
-
-    len = sizeof(tmp);
-    memcpy(*cmd, tmp, len);
   }
-
-  return len;
-}
-
-void send_heatpump_command(char* topic, char *msg, bool (*send_command)(byte*, int), void (*log_message)(char*)) {
-  unsigned char cmd[256] = { 0 }, *p = cmd;
-  char log_msg[256] = { 0 }, *l = log_msg;
-  unsigned int len = 0;
-
-  int arraysize = sizeof(commands) / sizeof(commands[0]);
-  int i = 0;
-
-  for (i = 0; i < arraysize; i++) {
-    if (strcmp(topic, commands[i].name) == 0) {
-      len = commands[i].func(msg, &p, &l);
-      log_message(log_msg);
-      send_command(cmd, len);
+  else if (pcbTopic == OPTIONALPCB_EXTERNAL_THERMOSTAT_2_STATE) {
+    byte set_pcb_value = set_pcb_string.toInt();
+    if (set_pcb_value < 4) {
+      optionalPCBQuery[optionalPcbBytes[pcbTopic]] = (optionalPCBQuery[optionalPcbBytes[pcbTopic]] & ~(0b11 << 0)) | ( set_pcb_value << 0 );
+      sprintf(log_msg, "set optional pcb %s to %d", optionalPcbTopics[pcbTopic], set_pcb_value); log_message(log_msg);
     }
   }
-}
-
-void set_optionalpcb(char* topic, char *msg, void (*log_message)(char*)) {
-  for (int i = 0 ; i < NUMBER_OF_OPTIONALPCB_TOPICS ; i++) {
-    if (strcmp(topic, optionalPcbTopics[i]) == 0) {
-      char log_msg[256];
-      String set_pcb_string(msg);
-      if (strstr(topic, "Temp")) {
-        float temp = set_pcb_string.toFloat();
-        float hextemp;
-        if (temp > 120) {
-          hextemp = 0;
-        } else if (temp < -78) {
-          hextemp = 255;
-        }
-        else {
-          byte Uref = 255;
-          int constant = 3695;
-          int R25 = 6340;
-          byte T25 = 25;
-          int Rf = 6480;
-          float K = 273.15;
-          float RT = R25 * exp(constant * (1 / (temp + K) - 1 / (T25 + K)));
-          hextemp = Uref * (RT / (Rf + RT));
-        }
-        optionalPCBQuery[optionalPcbBytes[i]] = (int)hextemp;
-        sprintf(log_msg, "set optional pcb %s to temp %.2f, hextemp DEC %.2f = HEX %x", optionalPcbTopics[i], temp, hextemp, (int)hextemp); log_message(log_msg);
-      }
-      else if (strcmp(topic, "Heat_Cool_Mode") == 0) {
-        bool set_pcb_value = (set_pcb_string.toInt() == 1);
-        optionalPCBQuery[optionalPcbBytes[i]] = (optionalPCBQuery[optionalPcbBytes[i]] & ~(0b1 << 7)) | ( set_pcb_value << 7 );
-        sprintf(log_msg, "set optional pcb %s to %d", optionalPcbTopics[i], set_pcb_value); log_message(log_msg);
-      }
-      else if (strcmp(topic, "Compressor_State") == 0) {
-        bool set_pcb_value = (set_pcb_string.toInt() == 1);
-        optionalPCBQuery[optionalPcbBytes[i]] = (optionalPCBQuery[optionalPcbBytes[i]] & ~(0b1 << 6)) | ( set_pcb_value << 6 );
-        sprintf(log_msg, "set optional pcb %s to %d", optionalPcbTopics[i], set_pcb_value); log_message(log_msg);
-      }
-      else if (strcmp(topic, "SmartGrid_Mode") == 0) {
-        byte set_pcb_value = set_pcb_string.toInt();
-        if (set_pcb_value < 4) {
-          optionalPCBQuery[optionalPcbBytes[i]] = (optionalPCBQuery[optionalPcbBytes[i]] & ~(0b11 << 4)) | ( set_pcb_value << 4 );
-          sprintf(log_msg, "set optional pcb %s to %d", optionalPcbTopics[i], set_pcb_value); log_message(log_msg);
-        }
-      }
-      else if (strcmp(topic, "External_Thermostat_1_State") == 0) {
-        byte set_pcb_value = set_pcb_string.toInt();
-        if (set_pcb_value < 4) {
-          optionalPCBQuery[optionalPcbBytes[i]] = (optionalPCBQuery[optionalPcbBytes[i]] & ~(0b11 << 2)) | ( set_pcb_value << 2 );
-          sprintf(log_msg, "set optional pcb %s to %d", optionalPcbTopics[i], set_pcb_value); log_message(log_msg);
-        }
-
-      }
-      else if (strcmp(topic, "External_Thermostat_2_State") == 0) {
-        byte set_pcb_value = set_pcb_string.toInt();
-        if (set_pcb_value < 4) {
-          optionalPCBQuery[optionalPcbBytes[i]] = (optionalPCBQuery[optionalPcbBytes[i]] & ~(0b11 << 0)) | ( set_pcb_value << 0 );
-          sprintf(log_msg, "set optional pcb %s to %d", optionalPcbTopics[i], set_pcb_value); log_message(log_msg);
-        }
-      }
-      else {
-        byte set_pcb_value = set_pcb_string.toInt();
-        optionalPCBQuery[optionalPcbBytes[i]] = set_pcb_value;
-        sprintf(log_msg, "set optional pcb %s to %s", optionalPcbTopics[i], msg); log_message(log_msg);
-      }
-
-    }
+  else {
+    byte set_pcb_value = set_pcb_string.toInt();
+    optionalPCBQuery[optionalPcbBytes[pcbTopic]] = set_pcb_value;
+    sprintf(log_msg, "set optional pcb %s to %s", optionalPcbTopics[pcbTopic], msg); log_message(log_msg);
   }
 }
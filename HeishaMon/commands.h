@@ -1,4 +1,6 @@
 #include <ESP8266WiFi.h>
+#include "commandqueue.h"
+#include "s0.h"
 
 
 #define PANASONICQUERYSIZE 110
@@ -8,7 +10,15 @@ extern byte panasonicQuery[PANASONICQUERYSIZE];
 extern byte optionalPCBQuery[OPTIONALPCBQUERYSIZE];
 #define NUMBER_OF_OPTIONALPCB_TOPICS 13
 
-static const char * optionalPcbTopics[] = {
+//optionalPcbTopics which are not simply a byte value
+#define OPTIONALPCB_HEAT_COOL_MODE 0
+#define OPTIONALPCB_COMPRESSOR_STATE 1
+#define OPTIONALPCB_SMARTGRID_MODE 2
+#define OPTIONALPCB_EXTERNAL_THERMOSTAT_1_STATE 3
+#define OPTIONALPCB_EXTERNAL_THERMOSTAT_2_STATE 4
+#define OPTIONALPCB_FIRST_TEMP 6 // this and the topics after it are temperatures
+
+static constexpr const char * optionalPcbTopics[] = {
   "Heat_Cool_Mode",
   "Compressor_State",
   "SmartGrid_Mode",
@@ -41,66 +51,43 @@ static const byte optionalPcbBytes[] = {
 };
 
 extern const char* mqtt_topic_values;
+extern const char* mqtt_topic_json;
 extern const char* mqtt_topic_1wire;
 extern const char* mqtt_topic_s0;
 extern const char* mqtt_topic_pcb;
 extern const char* mqtt_logtopic;
+extern const char* mqtt_topic_serialstats;
+extern const char* mqtt_topic_loopstats;
+extern const char* mqtt_topic_heapstats;
 extern const char* mqtt_willtopic;
 extern const char* mqtt_iptopic;
-extern const char* mqtt_send_raw_value_topic;
 
 
-unsigned int set_heatpump_state(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_pump(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_pump_speed(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_quiet_mode(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_z1_heat_request_temperature(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_z1_cool_request_temperature(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_z2_heat_request_temperature(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_z2_cool_request_temperature(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_force_DHW(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_force_defrost(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_force_sterilization(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_holiday_mode(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_powerful_mode(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_operation_mode(char *msg, unsigned char **cmd, char **log_msg);
-unsigned int set_DHW_temp(char *msg, unsigned char **cmd, char **log_msg);
+#define NUMBER_OF_COMMANDS 15
+#define COMMAND_NAME_SIZE 32
+#define COMMAND_LOG_SIZE 96
+
+//kinds of command topics, what the mqtt callback does with a message
+#define COMMAND_TOPIC_SET 0 // heatpump set command, index in commandDescriptors
+#define COMMAND_TOPIC_PCB 1 // optional pcb value, index in optionalPcbTopics
+#define COMMAND_TOPIC_RAW 2 // raw command sent as is
+#define COMMAND_TOPIC_S0 3  // restore of the s0 watthour total, index is the s0 port
 
-struct {
-  const char *name;
-  unsigned int (*func)(char *msg, unsigned char **cmd, char **log_msg);
-}commands[] = {
-  // set heatpump state to on by sending 1
-  { "SetHeatpump", set_heatpump_state },
-  // set pump state to on by sending 1
-  { "SetPump", set_pump },
-  // set pump speed
-  { "SetPumpSpeed", set_pump_speed },
-  // set 0 for Off mode, set 1 for Quiet mode 1, set 2 for Quiet mode 2, set 3 for Quiet mode 3
-  { "SetQuietMode", set_quiet_mode },
-  // z1 heat request temp -  set from -5 to 5 to get same temperature shift point or set direct temp
-  { "SetZ1HeatRequestTemperature", set_z1_heat_request_temperature },
-  // z1 cool request temp -  set from -5 to 5 to get same temperature shift point or set direct temp
-  { "SetZ1CoolRequestTemperature", set_z1_cool_request_temperature },
-  // z2 heat request temp -  set from -5 to 5 to get same temperature shift point or set direct temp
-  { "SetZ2HeatRequestTemperature", set_z2_heat_request_temperature },
-  // z2 cool request temp -  set from -5 to 5 to get same temperature shift point or set direct temp
-  { "SetZ2CoolRequestTemperature", set_z2_cool_request_temperature },
-  // set mode to force DHW by sending 1
-  { "SetForceDHW", set_force_DHW },
-  // set mode to force defrost  by sending 1
-  { "SetForceDefrost", set_force_defrost },
-  // set mode to force sterilization by sending 1
-  { "SetForceSterilization", set_force_sterilization },
-  // set Holiday mode by sending 1, off will be 0
-  { "SetHolidayMode", set_holiday_mode },
-  // set Powerful mode by sending 0 = off, 1 for 30min, 2 for 60min, 3 for 90 min
-  { "SetPowerfulMode", set_powerful_mode },
-  // set Heat pump operation mode  3 = DHW only, 0 = heat only, 1 = cool only, 2 = Auto, 4 = Heat+DHW, 5 = Cool+DHW, 6 = Auto + DHW
-  { "SetOperationMode", set_operation_mode },
-  // set DHW temperature by sending desired temperature between 40C-75C
-  { "SetDHWTemp", set_DHW_temp }
+#define NUMBER_OF_COMMAND_TOPICS 31
+
+// every topic below the mqtt base topic a command can be sent to, sorted by name (strcmp order, so
+// uppercase before lowercase) for a binary search
+struct commandTopicStruct {
+  char name[COMMAND_NAME_SIZE];
+  byte kind;  // COMMAND_TOPIC_*
+  byte index;
 };
 
-void send_heatpump_command(char* topic, char *msg,bool (*send_command)(byte*, int),void (*log_message)(char*));
-void set_optionalpcb(char* topic, char *msg,void (*log_message)(char*));
+extern const commandTopicStruct commandTopics[NUMBER_OF_COMMAND_TOPICS]; // in flash (PROGMEM), defined once in commands.cpp
+
+unsigned int encodeCommand(unsigned int command, char *msg, byte *cmd, char *log_msg);
+bool findCommandTopic(const char *name, byte *kind, byte *index);
+int findCommand(const char *name);
+void getCommandName(unsigned int command, char *buffer);
+void send_heatpump_command(unsigned int command, char *msg,bool (*send_command)(byte*, int, byte),void (*log_message)(char*));
+void set_optionalpcb(unsigned int pcbTopic, char *msg,void (*log_message)(char*));
@@ -3,6 +3,8 @@
 #include <PubSubClient.h>
 #include "commands.h"
 #include "dallas.h"
+#include "publish.h"
+#include "dataversion.h"
 
 #define MQTT_RETAIN_VALUES 1 // do we retain 1wire values?
 
@@ -16,6 +18,7 @@ DallasTemperature DS18B20(&oneWire);
 //global array for 1wire data
 dallasDataStruct* actDallasData = 0;
 int dallasDevicecount = 0;
+unsigned long dallasErrors = 0; //number of failed sensor reads since boot
 
 
 unsigned long nextalldatatime_dallas = 0;
@@ -54,9 +57,8 @@ void initDallasSensors(void (*log_message)(char*), unsigned int updateAllDallasT
   if (DALLASASYNC) DS18B20.setWaitForConversion(false); //async 1wire during next loops
 }
 
-void readNewDallasTemp(PubSubClient &mqtt_client, void (*log_message)(char*), char* mqtt_topic_base) {
+void readNewDallasTemp(PubSubClient &mqtt_client, void (*log_message)(char*), mqttTopicStruct *mqttTopic1wire) {
   char log_msg[256];
-  char mqtt_topic[256];
   char valueStr[20];
   bool updatenow = false;
 
@@ -68,6 +70,7 @@ void readNewDallasTemp(PubSubClient &mqtt_client, void (*log_message)(char*), ch
   for (int i = 0; i < dallasDevicecount; i++) {
     float temp = DS18B20.getTempC(actDallasData[i].sensor);
     if (temp < -120.0) {
+      dallasErrors++;
       sprintf(log_msg, "Error 1wire sensor offline: %s", actDallasData[i].address); log_message(log_msg);
     } else {
       float allowedtempdiff = (((millis() - actDallasData[i].lastgoodtime)) / 1000.0) * MAXTEMPDIFFPERSEC;
@@ -76,38 +79,42 @@ void readNewDallasTemp(PubSubClient &mqtt_client, void (*log_message)(char*), ch
       } else {
         actDallasData[i].lastgoodtime = millis();
         if ((updatenow) || (actDallasData[i].temperature != temp )) {  //only update mqtt topic if temp changed or after each update timer
+          if (actDallasData[i].temperature != temp) dataChanged(DATA_DALLAS);
           actDallasData[i].temperature = temp;
-          sprintf(log_msg, "Received 1wire sensor temperature (%s): %.2f", actDallasData[i].address, actDallasData[i].temperature); log_message(log_msg);
-          sprintf(valueStr, "%.2f", actDallasData[i].temperature);
-          sprintf(mqtt_topic, "%s/%s/%s", mqtt_topic_base, mqtt_topic_1wire, actDallasData[i].address); mqtt_client.publish(mqtt_topic, valueStr, MQTT_RETAIN_VALUES);
+          formatDecimal(lrintf(actDallasData[i].temperature * 100), 2, valueStr);
+          sprintf(log_msg, "Received 1wire sensor temperature (%s): %s", actDallasData[i].address, valueStr); log_message(log_msg);
+          mqtt_client.publish(getMqttTopic(mqttTopic1wire, actDallasData[i].address), valueStr, MQTT_RETAIN_VALUES);
         }
       }
     }
   }
 }
 
-void dallasLoop(PubSubClient &mqtt_client, void (*log_message)(char*), char* mqtt_topic_base) {
+void dallasLoop(PubSubClient &mqtt_client, void (*log_message)(char*), mqttTopicStruct *mqttTopic1wire) {
   if ((DALLASASYNC) && (millis() > (dallasTimer - 1000))) {
     DS18B20.requestTemperatures(); // get temperatures for next run 1 second before getting the temperatures (async)
   }
   if (millis() > dallasTimer) {
     log_message((char*)"Requesting new 1wire temperatures");
     dallasTimer = millis() + (1000 * dallasTimerWait);
-    readNewDallasTemp(mqtt_client, log_message, mqtt_topic_base);
+    readNewDallasTemp(mqtt_client, log_message, mqttTopic1wire);
   }
 }
 
-String dallasJsonOutput() {
-  String output = "[";
+unsigned long getDallasErrors() {
+  return dallasErrors;
+}
+
+// The sensors as objects in the json array which is written
+void dallasJsonOutput(jsonWriterStruct *json) {
+  char valueStr[20];
   for (int i = 0; i < dallasDevicecount; i++) {
-    output = output + "{";
-    output = output + "\"Sensor\": \"" + actDallasData[i].address + "\",";
-    output = output + "\"Temperature\": \"" + actDallasData[i].temperature + "\"";
-    output = output + "}";
-    if (i < dallasDevicecount - 1) output = output + ",";
+    jsonObjectBegin(json, 0);
+    jsonString(json, PSTR("Sensor"), actDallasData[i].address);
+    formatDecimal(lrintf(actDallasData[i].temperature * 100), 2, valueStr);
+    jsonString(json, PSTR("Temperature"), valueStr);
+    jsonObjectEnd(json);
   }
-  output = output + "]";
-  return output;
 }
 
 String dallasTableOutput() {
@@ -1,6 +1,8 @@
 #include <PubSubClient.h>
 #include <OneWire.h>
 #include <DallasTemperature.h>
+#include "publish.h"
+#include "jsonwriter.h"
 
 #define MAX_DALLAS_SENSORS 15
 #define ONE_WIRE_BUS 4  // DS18B20 pin, for now a static config - should be in config menu later
@@ -12,7 +14,8 @@ struct dallasDataStruct {
   char address[17];
 };
 
-void dallasLoop(PubSubClient &mqtt_client, void (*log_message)(char*), char* mqtt_topic_base);
+void dallasLoop(PubSubClient &mqtt_client, void (*log_message)(char*), mqttTopicStruct *mqttTopic1wire);
 void initDallasSensors(void (*log_message)(char*), unsigned int updataAllDallasTimeSettings, unsigned int dallasTimerWaitSettings);
-String dallasJsonOutput(void);
+unsigned long getDallasErrors(void);
+void dallasJsonOutput(jsonWriterStruct *json);
 String dallasTableOutput(void);
@@ -0,0 +1,20 @@
+#include "dataversion.h"
+
+// Versions of the data, they only move when a value actually changed so the web pages can be answered
+// with 304 Not Modified as long as the version in the ETag of the browser is still the same.
+
+static unsigned long dataVersions[NUMBER_OF_DATA_SOURCES] = { 0 };
+static unsigned long dataVersion = 0; // moves with the version of each source
+
+void dataChanged(byte source) {
+  dataVersions[source]++;
+  dataVersion++;
+}
+
+unsigned long getDataVersion(byte source) {
+  return dataVersions[source];
+}
+
+unsigned long getDataVersion() {
+  return dataVersion;
+}
@@ -0,0 +1,16 @@
+#ifndef DATAVERSION_H
+#define DATAVERSION_H
+
+#include <Arduino.h>
+
+//sources of the values shown on the web pages, each has its own version
+#define DATA_HEATPUMP 0
+#define DATA_DALLAS 1
+#define DATA_S0 2
+#define NUMBER_OF_DATA_SOURCES 3
+
+void dataChanged(byte source);
+unsigned long getDataVersion(byte source);
+unsigned long getDataVersion(void);
+
+#endif
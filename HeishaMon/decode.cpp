@@ -1,162 +1,642 @@
 #include "decode.h"
 #include "commands.h"
+#include "dataversion.h"
 
-unsigned long nextalldatatime = 0;
+// enum labels are separated by | and indexed by the decoded value
+static constexpr char DisabledEnabled[] PROGMEM = "Disabled|Enabled";
+static constexpr char BlockedFree[] PROGMEM = "Blocked|Free";
+static constexpr char OffOn[] PROGMEM = "Off|On";
+static constexpr char InactiveActive[] PROGMEM = "Inactive|Active";
+static constexpr char HolidayState[] PROGMEM = "Off|Scheduled|Active";
+static constexpr char OpModeDesc[] PROGMEM = "Heat|Cool|Auto(heat)|DHW|Heat+DHW|Cool+DHW|Auto(heat)+DHW|Auto(cool)|Auto(cool)+DHW";
+static constexpr char Powerfulmode[] PROGMEM = "Off|30min|60min|90min";
+static constexpr char Quietmode[] PROGMEM = "Off|Level 1|Level 2|Level 3";
+static constexpr char Valve[] PROGMEM = "Room|DHW";
+static constexpr char HeatCoolModeDesc[] PROGMEM = "Comp. Curve|Direct";
+static constexpr char Model[] PROGMEM = "WH-MDC05H3E5|WH-MDC07H3E5|IDU:WH-SXC09H3E5, ODU:WH-UX09HE5|IDU:WH-SDC09H3E8, ODU:WH-UD09HE8|IDU:WH-SXC09H3E8, ODU:WH-UX09HE8|IDU:WH-SXC12H9E8, ODU:WH-UX12HE8|IDU:WH-SXC16H9E8, ODU:WH-UX16HE8|IDU:WH-SDC05H3E5, ODU:WH-UD05HE5|IDU:WH-SDC0709J3E5, ODU:WH-UD09JE5|WH-MDC05J3E5|WH-MDC09H3E5|WH-MXC09H3E5|IDU:WH-ADC0309J3E5, ODU:WH-UD09JE5|IDU:WH-ADC0916H9E8, ODU:WH-UX12HE8|IDU:WH-SQC09H3E8, ODU:WH-UQ09HE8";
+
+static constexpr char LitersPerMin[] PROGMEM = "l/min";
+static constexpr char RotationsPerMin[] PROGMEM = "r/min";
+static constexpr char Pressure[] PROGMEM = "Kgf/cm2";
+static constexpr char Celsius[] PROGMEM = "&deg;C";
+static constexpr char Kelvin[] PROGMEM = "K";
+static constexpr char Hertz[] PROGMEM = "Hz";
+static constexpr char Counter[] PROGMEM = "count";
+static constexpr char Hours[] PROGMEM = "hours";
+static constexpr char Watt[] PROGMEM = "Watt";
+static constexpr char ErrorState[] PROGMEM = "Error";
+static constexpr char Ampere[] PROGMEM = "Ampere";
+static constexpr char Minutes[] PROGMEM = "Minutes";
+static constexpr char Duty[] PROGMEM = "Duty";
 
-String getBit1and2(byte input) {
-  return String((input  >> 6)-1);
+constexpr topicDescriptorStruct topicDescriptors[NUMBER_OF_TOPICS] PROGMEM = {
+  //name                               byte #  decoder                        type              unit             labels
+  { "Heatpump_State",                  4,   1, TOPIC_DECODE_BIT7AND8,         TOPIC_TYPE_INT,   0,               OffOn            }, //TOP0
+  { "Pump_Flow",                       169, 2, TOPIC_DECODE_PUMPFLOW,         TOPIC_TYPE_DEC2,  LitersPerMin,    0                }, //TOP1
+  { "Force_DHW_State",                 4,   1, TOPIC_DECODE_BIT1AND2,         TOPIC_TYPE_INT,   0,               DisabledEnabled  }, //TOP2
+  { "Quiet_Mode_Schedule",             7,   1, TOPIC_DECODE_BIT1AND2,         TOPIC_TYPE_INT,   0,               DisabledEnabled  }, //TOP3
+  { "Operating_Mode_State",            6,   1, TOPIC_DECODE_OPMODE,           TOPIC_TYPE_INT,   0,               OpModeDesc       }, //TOP4
+  { "Main_Inlet_Temp",                 143, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP5
+  { "Main_Outlet_Temp",                144, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP6
+  { "Main_Target_Temp",                153, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP7
+  { "Compressor_Freq",                 166, 1, TOPIC_DECODE_INTMINUS1,        TOPIC_TYPE_INT,   Hertz,           0                }, //TOP8
+  { "DHW_Target_Temp",                 42,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP9
+  { "DHW_Temp",                        141, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP10
+  { "Operations_Hours",                182, 2, TOPIC_DECODE_WORDMINUS1,       TOPIC_TYPE_INT,   Hours,           0                }, //TOP11
+  { "Operations_Counter",              179, 2, TOPIC_DECODE_WORDMINUS1,       TOPIC_TYPE_INT,   Counter,         0                }, //TOP12
+  { "Main_Schedule_State",             5,   1, TOPIC_DECODE_BIT1AND2,         TOPIC_TYPE_INT,   0,               DisabledEnabled  }, //TOP13
+  { "Outside_Temp",                    142, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP14
+  { "Heat_Energy_Production",          194, 1, TOPIC_DECODE_ENERGY,           TOPIC_TYPE_INT,   Watt,            0                }, //TOP15
+  { "Heat_Energy_Consumption",         193, 1, TOPIC_DECODE_ENERGY,           TOPIC_TYPE_INT,   Watt,            0                }, //TOP16
+  { "Powerful_Mode_Time",              7,   1, TOPIC_DECODE_RIGHT3BITS,       TOPIC_TYPE_INT,   0,               Powerfulmode     }, //TOP17
+  { "Quiet_Mode_Level",                7,   1, TOPIC_DECODE_BIT3AND4AND5,     TOPIC_TYPE_INT,   0,               Quietmode        }, //TOP18
+  { "Holiday_Mode_State",              5,   1, TOPIC_DECODE_BIT3AND4,         TOPIC_TYPE_INT,   0,               HolidayState     }, //TOP19
+  { "ThreeWay_Valve_State",            111, 1, TOPIC_DECODE_BIT7AND8,         TOPIC_TYPE_INT,   0,               Valve            }, //TOP20
+  { "Outside_Pipe_Temp",               158, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP21
+  { "DHW_Heat_Delta",                  99,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Kelvin,          0                }, //TOP22
+  { "Heat_Delta",                      84,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Kelvin,          0                }, //TOP23
+  { "Cool_Delta",                      94,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Kelvin,          0                }, //TOP24
+  { "DHW_Holiday_Shift_Temp",          44,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Kelvin,          0                }, //TOP25
+  { "Defrosting_State",                111, 1, TOPIC_DECODE_BIT5AND6,         TOPIC_TYPE_INT,   0,               DisabledEnabled  }, //TOP26
+  { "Z1_Heat_Request_Temp",            38,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP27
+  { "Z1_Cool_Request_Temp",            39,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP28
+  { "Z1_Heat_Curve_Target_High_Temp",  75,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP29
+  { "Z1_Heat_Curve_Target_Low_Temp",   76,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP30
+  { "Z1_Heat_Curve_Outside_High_Temp", 78,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP31
+  { "Z1_Heat_Curve_Outside_Low_Temp",  77,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP32
+  { "Room_Thermostat_Temp",            156, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP33
+  { "Z2_Heat_Request_Temp",            40,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP34
+  { "Z2_Cool_Request_Temp",            41,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP35
+  { "Z1_Water_Temp",                   145, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP36
+  { "Z2_Water_Temp",                   146, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP37
+  { "Cool_Energy_Production",          196, 1, TOPIC_DECODE_ENERGY,           TOPIC_TYPE_INT,   Watt,            0                }, //TOP38
+  { "Cool_Energy_Consumption",         195, 1, TOPIC_DECODE_ENERGY,           TOPIC_TYPE_INT,   Watt,            0                }, //TOP39
+  { "DHW_Energy_Production",           198, 1, TOPIC_DECODE_ENERGY,           TOPIC_TYPE_INT,   Watt,            0                }, //TOP40
+  { "DHW_Energy_Consumption",          197, 1, TOPIC_DECODE_ENERGY,           TOPIC_TYPE_INT,   Watt,            0                }, //TOP41
+  { "Z1_Water_Target_Temp",            147, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP42
+  { "Z2_Water_Target_Temp",            148, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP43
+  { "Error",                           113, 2, TOPIC_DECODE_ERRORINFO,        TOPIC_TYPE_ERROR, ErrorState,      0                }, //TOP44
+  { "Room_Holiday_Shift_Temp",         43,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Kelvin,          0                }, //TOP45
+  { "Buffer_Temp",                     149, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP46
+  { "Solar_Temp",                      150, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP47
+  { "Pool_Temp",                       151, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP48
+  { "Main_Hex_Outlet_Temp",            154, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP49
+  { "Discharge_Temp",                  155, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP50
+  { "Inside_Pipe_Temp",                157, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP51
+  { "Defrost_Temp",                    159, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP52
+  { "Eva_Outlet_Temp",                 160, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP53
+  { "Bypass_Outlet_Temp",              161, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP54
+  { "Ipm_Temp",                        162, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP55
+  { "Z1_Temp",                         139, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP56
+  { "Z2_Temp",                         140, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP57
+  { "DHW_Heater_State",                9,   1, TOPIC_DECODE_BIT5AND6,         TOPIC_TYPE_INT,   0,               BlockedFree      }, //TOP58
+  { "Room_Heater_State",               9,   1, TOPIC_DECODE_BIT7AND8,         TOPIC_TYPE_INT,   0,               BlockedFree      }, //TOP59
+  { "Internal_Heater_State",           112, 1, TOPIC_DECODE_BIT7AND8,         TOPIC_TYPE_INT,   0,               InactiveActive   }, //TOP60
+  { "External_Heater_State",           112, 1, TOPIC_DECODE_BIT5AND6,         TOPIC_TYPE_INT,   0,               InactiveActive   }, //TOP61
+  { "Fan1_Motor_Speed",                173, 1, TOPIC_DECODE_INTMINUS1TIMES10, TOPIC_TYPE_INT,   RotationsPerMin, 0                }, //TOP62
+  { "Fan2_Motor_Speed",                174, 1, TOPIC_DECODE_INTMINUS1TIMES10, TOPIC_TYPE_INT,   RotationsPerMin, 0                }, //TOP63
+  { "High_Pressure",                   163, 1, TOPIC_DECODE_INTMINUS1DIV5,    TOPIC_TYPE_DEC1,  Pressure,        0                }, //TOP64
+  { "Pump_Speed",                      171, 1, TOPIC_DECODE_INTMINUS1TIMES50, TOPIC_TYPE_INT,   RotationsPerMin, 0                }, //TOP65
+  { "Low_Pressure",                    164, 1, TOPIC_DECODE_INTMINUS1,        TOPIC_TYPE_INT,   Pressure,        0                }, //TOP66
+  { "Compressor_Current",              165, 1, TOPIC_DECODE_INTMINUS1DIV5,    TOPIC_TYPE_DEC1,  Ampere,          0                }, //TOP67
+  { "Force_Heater_State",              5,   1, TOPIC_DECODE_BIT5AND6,         TOPIC_TYPE_INT,   0,               InactiveActive   }, //TOP68
+  { "Sterilization_State",             117, 1, TOPIC_DECODE_BIT5AND6,         TOPIC_TYPE_INT,   0,               InactiveActive   }, //TOP69
+  { "Sterilization_Temp",              100, 1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP70
+  { "Sterilization_Max_Time",          101, 1, TOPIC_DECODE_INTMINUS1,        TOPIC_TYPE_INT,   Minutes,         0                }, //TOP71
+  { "Z1_Cool_Curve_Target_High_Temp",  86,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP72
+  { "Z1_Cool_Curve_Target_Low_Temp",   87,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP73
+  { "Z1_Cool_Curve_Outside_High_Temp", 88,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP74
+  { "Z1_Cool_Curve_Outside_Low_Temp",  89,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP75
+  { "Heating_Mode",                    28,  1, TOPIC_DECODE_BIT7AND8,         TOPIC_TYPE_INT,   0,               HeatCoolModeDesc }, //TOP76
+  { "Heating_Off_Outdoor_Temp",        83,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP77
+  { "Heater_On_Outdoor_Temp",          85,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP78
+  { "Heat_To_Cool_Temp",               95,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP79
+  { "Cool_To_Heat_Temp",               96,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP80
+  { "Cooling_Mode",                    28,  1, TOPIC_DECODE_BIT5AND6,         TOPIC_TYPE_INT,   0,               HeatCoolModeDesc }, //TOP81
+  { "Z2_Heat_Curve_Target_High_Temp",  79,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP82
+  { "Z2_Heat_Curve_Target_Low_Temp",   80,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP83
+  { "Z2_Heat_Curve_Outside_High_Temp", 81,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP84
+  { "Z2_Heat_Curve_Outside_Low_Temp",  82,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP85
+  { "Z2_Cool_Curve_Target_High_Temp",  90,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP86
+  { "Z2_Cool_Curve_Target_Low_Temp",   91,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP87
+  { "Z2_Cool_Curve_Outside_High_Temp", 92,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP88
+  { "Z2_Cool_Curve_Outside_Low_Temp",  93,  1, TOPIC_DECODE_INTMINUS128,      TOPIC_TYPE_INT,   Celsius,         0                }, //TOP89
+  { "Room_Heater_Operations_Hours",    185, 2, TOPIC_DECODE_WORDMINUS1,       TOPIC_TYPE_INT,   Hours,           0                }, //TOP90
+  { "DHW_Heater_Operations_Hours",     188, 2, TOPIC_DECODE_WORDMINUS1,       TOPIC_TYPE_INT,   Hours,           0                }, //TOP91
+  { "Heat_Pump_Model",                 132, 1, TOPIC_DECODE_MODEL,            TOPIC_TYPE_INT,   0,               Model            }, //TOP92
+  { "Pump_Duty",                       172, 1, TOPIC_DECODE_INTMINUS1,        TOPIC_TYPE_INT,   Duty,            0                }, //TOP93
+};
+
+// compile time checks of the topic table, add a topic to the table and update NUMBER_OF_TOPICS together
+static constexpr unsigned int topicLabelCount(const char *labels, unsigned int count = 1) {
+  return (*labels == '\0') ? count : topicLabelCount(labels + 1, count + (*labels == '|'));
 }
 
-String getBit3and4(byte input) {
-  return String(((input >> 4) & 0b11)-1);
+static constexpr bool topicTwoByteDecoder(byte decoder) {
+  return (decoder == TOPIC_DECODE_PUMPFLOW) || (decoder == TOPIC_DECODE_WORDMINUS1) || (decoder == TOPIC_DECODE_ERRORINFO);
 }
 
-String getBit5and6(byte input) {
-  return String(((input >> 2) & 0b11)-1);
+static constexpr bool topicDescriptorValid(const topicDescriptorStruct &topic) {
+  return (topic.name[0] != '\0') &&
+         (topic.byteCount == (topicTwoByteDecoder(topic.decoder) ? 2 : 1)) &&
+         (topic.firstByte + topic.byteCount <= PANASONICDATASIZE) &&
+         ((topic.unit == 0) != (topic.labels == 0)) &&
+         ((topic.type == TOPIC_TYPE_DEC2) == (topic.decoder == TOPIC_DECODE_PUMPFLOW)) &&
+         ((topic.type == TOPIC_TYPE_DEC1) == (topic.decoder == TOPIC_DECODE_INTMINUS1DIV5)) &&
+         ((topic.type == TOPIC_TYPE_ERROR) == (topic.decoder == TOPIC_DECODE_ERRORINFO));
 }
 
-String getBit7and8(byte input) {
-  return String((input & 0b11)-1);
+static constexpr bool topicDescriptorsValid(unsigned int topic = 0) {
+  return (topic == NUMBER_OF_TOPICS) || (topicDescriptorValid(topicDescriptors[topic]) && topicDescriptorsValid(topic + 1));
 }
 
-String getBit3and4and5(byte input) {
-  return String(((input >> 3) & 0b111)-1);
+static_assert(sizeof(topicDescriptors) / sizeof(topicDescriptors[0]) == NUMBER_OF_TOPICS, "topicDescriptors must have NUMBER_OF_TOPICS entries");
+static_assert(topicDescriptorsValid(), "topicDescriptors has an entry with a wrong byte count, decoder, type or description");
+static_assert(topicLabelCount(OpModeDesc) == 9, "getOpMode decodes 9 operating modes");
+static_assert(topicLabelCount(Model) == 15, "getModel decodes 15 models");
+
+unsigned long nextalldatatime = 0;
+
+// previous frame, used to only decode the topics of which the source bytes changed
+byte lastData[PANASONICDATASIZE];
+bool lastDataValid = false;
+
+// topics of which the value changed since takeChangedTopics, one bit per topic
+byte changedTopics[(NUMBER_OF_TOPICS + 7) / 8];
+
+// publish filters, topicFilterIndex holds the filter number plus one of each topic or NO_TOPIC_FILTER
+topicFilterStruct topicFilters[MAX_TOPIC_FILTERS];
+byte topicFilterCount = 0;
+byte topicFilterIndex[NUMBER_OF_TOPICS];
+
+int32_t getBit1and2(byte input) {
+  return (input >> 6) - 1;
 }
 
+int32_t getBit3and4(byte input) {
+  return ((input >> 4) & 0b11) - 1;
+}
 
-String getLeft5bits(byte input) {
-  return String((input >> 3)-1);
+int32_t getBit5and6(byte input) {
+  return ((input >> 2) & 0b11) - 1;
 }
 
-String getRight3bits(byte input) {
-  return String((input & 0b111)-1);
+int32_t getBit7and8(byte input) {
+  return (input & 0b11) - 1;
 }
 
-String getIntMinus1(byte input) {
-  int value = (int)input - 1;
-  return (String)value;
+int32_t getBit3and4and5(byte input) {
+  return ((input >> 3) & 0b111) - 1;
 }
 
-String getIntMinus128(byte input) {
-  int value = (int)input - 128;
-  return (String)value;
+
+int32_t getLeft5bits(byte input) {
+  return (input >> 3) - 1;
 }
 
-String getIntMinus1Div5(byte input){
-  return String((((float)input - 1) / 5),1);
-  
+int32_t getRight3bits(byte input) {
+  return (input & 0b111) - 1;
 }
-String getIntMinus1Times10(byte input){
-  int value = (int)input - 1;
-  return (String)(value*10);
-  
+
+int32_t getIntMinus1(byte input) {
+  return (int32_t)input - 1;
 }
-String getIntMinus1Times50(byte input){
-  int value = (int)input - 1;
-  return (String)(value*50);
+
+int32_t getIntMinus128(byte input) {
+  return (int32_t)input - 128;
 }
 
-String unknown(byte input) {
-  return "-1";
+int32_t getIntMinus1Div5(byte input) { // TOPIC_TYPE_DEC1 so result is in tenths
+  return ((int32_t)input - 1) * 2;
 }
 
-String getOpMode(byte input) {
+int32_t getIntMinus1Times10(byte input) {
+  return ((int32_t)input - 1) * 10;
+}
+
+int32_t getIntMinus1Times50(byte input) {
+  return ((int32_t)input - 1) * 50;
+}
+
+int32_t getOpMode(byte input) {
   switch ((int)(input & 0b111111)) {
     case 18:
-      return "0";
+      return 0;
     case 19:
-      return "1";
+      return 1;
     case 25:
-      return "2";
+      return 2;
     case 33:
-      return "3";
+      return 3;
     case 34:
-      return "4";
+      return 4;
     case 35:
-      return "5";
+      return 5;
     case 41:
-      return "6";
+      return 6;
     case 26:
-      return "7";
+      return 7;
     case 42:
-      return "8";
+      return 8;
     default:
-      return "-1";
+      return -1;
   }
 }
 
-String getModel(byte input) {
+int32_t getModel(byte input) {
   switch ((int)input) {
     case 19:
-      return "0";
+      return 0;
     case 20:
-      return "1";
+      return 1;
     case 119:
-      return "2";
+      return 2;
     case 136:
-      return "3";
+      return 3;
     case 133:
-      return "4";
+      return 4;
     case 134:
-      return "5";
+      return 5;
     case 135:
-      return "6";
+      return 6;
     case 113:
-      return "7";
+      return 7;
     case 67:
-      return "8";
+      return 8;
     case 51:
-      return "9";
+      return 9;
     case 21:
-      return "10";
+      return 10;
     case 65:
-      return "11";     
+      return 11;
     case 69:
-      return "12";        
+      return 12;
     case 116:
-      return "13";
+      return 13;
     case 130:
-      return "14";
+      return 14;
     default:
-      return "-1";
+      return -1;
   }
 }
 
-String getEnergy(byte input)
-    {
-      int value = ((int)input - 1) * 200;
-      return (String)value;
+int32_t getEnergy(byte input) {
+  return ((int32_t)input - 1) * 200;
 }
 
-String getPumpFlow(char* data){   // TOP1 //
-  int PumpFlow1 = (int)data[170];
-  float PumpFlow2 = (((float)data[169]-1) / 256);
-  float PumpFlow = PumpFlow1 + PumpFlow2;
-  return String(PumpFlow,2);
+int32_t getPumpFlow(char* data) {  // TOP1 // TOPIC_TYPE_DEC2 so result is in hundredths
+  int32_t PumpFlow = ((int32_t)(byte)data[170] * 256) + (byte)data[169] - 1; // in 1/256 l/min
+  if (PumpFlow < 0) return -((-PumpFlow * 100 + 128) / 256);
+  return (PumpFlow * 100 + 128) / 256;
 }
 
-String getErrorInfo(char* data){ // TOP44 //
-  int Error_type = (int)(data[113]);
-  int Error_number = ((int)(data[114])) - 17;
-  char Error_string[10];
+int32_t getErrorInfo(char* data) { // TOP44 //
+  int Error_type = (int)((byte)data[113]);
+  int16_t Error_number = ((int)((byte)data[114])) - 17;
   switch (Error_type) {
     case 177:                  //B1=F type error
-      sprintf(Error_string, "F%02X", Error_number);
-      break;
+      return ((int32_t)'F' << 16) | (uint16_t)Error_number;
     case 161:                  //A1=H type error
-      sprintf(Error_string, "H%02X", Error_number);
+      return ((int32_t)'H' << 16) | (uint16_t)Error_number;
+    default:
+      return 0;
+  }
+}
+
+// Format a decoded value as text into buffer (at least TOPIC_VALUE_TEXT_SIZE bytes), returns buffer
+char* formatTopicValue(unsigned int topic, int32_t value, char* buffer) {
+  switch (pgm_read_byte(&topicDescriptors[topic].type)) {
+    case TOPIC_TYPE_DEC1:
+      formatDecimal(value, 1, buffer);
+      break;
+    case TOPIC_TYPE_DEC2:
+      formatDecimal(value, 2, buffer);
+      break;
+    case TOPIC_TYPE_ERROR:
+      if (value == 0) {
+        strcpy(buffer, "No error");
+      } else {
+        sprintf(buffer, "%c%02X", (char)(value >> 16), (int)(int16_t)(value & 0xFFFF));
+      }
+      break;
+    default:
+      formatInteger(value, buffer);
       break;
+  }
+  return buffer;
+}
+
+// Copy the name of a topic from the topic table into buffer (at least TOPIC_NAME_SIZE bytes), returns buffer
+char* getTopicName(unsigned int topic, char* buffer) {
+  strcpy_P(buffer, topicDescriptors[topic].name);
+  return buffer;
+}
+
+// Copy the unit of a topic, or the enum label of value, into buffer (at least TOPIC_DESCRIPTION_TEXT_SIZE bytes), returns buffer
+char* getTopicDescription(unsigned int topic, int32_t value, char* buffer) {
+  const char *unit = (const char *)pgm_read_ptr(&topicDescriptors[topic].unit);
+  if (unit) {
+    strcpy_P(buffer, unit);
+    return buffer;
+  }
+  if (!getTopicLabel(topic, value, buffer)) strcpy(buffer, "unknown");
+  return buffer;
+}
+
+// Copy enum label number label of a topic into buffer (at least TOPIC_DESCRIPTION_TEXT_SIZE bytes), returns
+// buffer, or 0 when the topic has a unit instead of labels or no such label
+char* getTopicLabel(unsigned int topic, int32_t label, char* buffer) {
+  const char *labels = (const char *)pgm_read_ptr(&topicDescriptors[topic].labels);
+  if (!labels) return 0;
+  //skip the labels before the wanted one
+  int32_t skipped = 0;
+  char c = pgm_read_byte(labels);
+  while ((skipped < label) && (c != '\0')) {
+    if (c == '|') skipped++;
+    c = pgm_read_byte(++labels);
+  }
+  if ((label < 0) || (skipped < label) || (c == '\0')) return 0;
+  unsigned int len = 0;
+  while ((c != '\0') && (c != '|') && (len < TOPIC_DESCRIPTION_TEXT_SIZE - 1)) {
+    buffer[len++] = c;
+    c = pgm_read_byte(++labels);
+  }
+  buffer[len] = '\0';
+  return buffer;
+}
+
+// The fixed part of the topics for /meta: {"Topic":"TOP0","Name":"Heatpump_State","Labels":["Off","On"]} or
+// with "Unit":"l/min" instead of the labels. It only changes with the firmware.
+void topicMetaJsonOutput(jsonWriterStruct *json) {
+  char topicText[16] = "TOP";
+  char text[TOPIC_DESCRIPTION_TEXT_SIZE];
+  for (unsigned int topic = 0 ; topic < NUMBER_OF_TOPICS ; topic++) {
+    formatUnsigned(topic, &topicText[3]);
+    jsonObjectBegin(json, 0);
+    jsonString(json, PSTR("Topic"), topicText);
+    jsonString(json, PSTR("Name"), getTopicName(topic, text));
+    const char *unit = (const char *)pgm_read_ptr(&topicDescriptors[topic].unit);
+    if (unit) {
+      strcpy_P(text, unit);
+      jsonString(json, PSTR("Unit"), text);
+    } else {
+      jsonArrayBegin(json, PSTR("Labels"));
+      for (int32_t label = 0 ; getTopicLabel(topic, label, text) ; label++) jsonString(json, 0, text);
+      jsonArrayEnd(json);
+    }
+    jsonObjectEnd(json);
+  }
+}
+
+// The values of all topics for /values, in topic order so they line up with /meta. Numbers, except the
+// error code which is a string.
+void topicValuesJsonOutput(jsonWriterStruct *json, int32_t actData[]) {
+  char valueText[TOPIC_VALUE_TEXT_SIZE];
+  for (unsigned int topic = 0 ; topic < NUMBER_OF_TOPICS ; topic++) {
+    formatTopicValue(topic, actData[topic], valueText);
+    if (pgm_read_byte(&topicDescriptors[topic].type) == TOPIC_TYPE_ERROR) jsonString(json, 0, valueText);
+    else jsonNumber(json, 0, valueText);
+  }
+}
+
+// Size of the topic table which is kept in flash instead of RAM
+unsigned int getTopicTableSize(void) {
+  return sizeof(topicDescriptors);
+}
+
+// Check if one of the bytes a topic is decoded from changed since the previous frame
+bool topicBytesChanged(unsigned int topic, byte* changedBytes) {
+  byte index = pgm_read_byte(&topicDescriptors[topic].firstByte);
+  byte count = pgm_read_byte(&topicDescriptors[topic].byteCount);
+  for (byte i = 0 ; i < count ; i++, index++) {
+    if (changedBytes[index >> 3] & (1 << (index & 7))) return true;
+  }
+  return false;
+}
+
+// Decode the value of a topic from the heatpump answer as described in the topic table
+int32_t decodeTopic(unsigned int topic, char* data) {
+  byte index = pgm_read_byte(&topicDescriptors[topic].firstByte);
+  byte input = data[index];
+  switch (pgm_read_byte(&topicDescriptors[topic].decoder)) {
+    case TOPIC_DECODE_BIT1AND2:
+      return getBit1and2(input);
+    case TOPIC_DECODE_BIT3AND4:
+      return getBit3and4(input);
+    case TOPIC_DECODE_BIT5AND6:
+      return getBit5and6(input);
+    case TOPIC_DECODE_BIT7AND8:
+      return getBit7and8(input);
+    case TOPIC_DECODE_BIT3AND4AND5:
+      return getBit3and4and5(input);
+    case TOPIC_DECODE_RIGHT3BITS:
+      return getRight3bits(input);
+    case TOPIC_DECODE_INTMINUS1:
+      return getIntMinus1(input);
+    case TOPIC_DECODE_INTMINUS128:
+      return getIntMinus128(input);
+    case TOPIC_DECODE_INTMINUS1DIV5:
+      return getIntMinus1Div5(input);
+    case TOPIC_DECODE_INTMINUS1TIMES10:
+      return getIntMinus1Times10(input);
+    case TOPIC_DECODE_INTMINUS1TIMES50:
+      return getIntMinus1Times50(input);
+    case TOPIC_DECODE_OPMODE:
+      return getOpMode(input);
+    case TOPIC_DECODE_ENERGY:
+      return getEnergy(input);
+    case TOPIC_DECODE_MODEL:
+      return getModel(input);
+    case TOPIC_DECODE_PUMPFLOW:
+      return getPumpFlow(data);
+    case TOPIC_DECODE_WORDMINUS1:
+      return (int32_t)word(data[index + 1], data[index]) - 1;
+    case TOPIC_DECODE_ERRORINFO:
+      return getErrorInfo(data);
     default:
-      sprintf(Error_string,"No error");
+      return -1;
+  }
+}
+
+// Set the publish filters from the setting text, a comma separated list of Name:deadband:percent:interval
+// (for example "Pump_Flow:0.1,Compressor_Current:0.2:0:60"), the deadband is in the unit of the topic,
+// percent and interval (seconds) are optional. Returns the number of filters.
+unsigned int setTopicFilters(const char* filters, void (*log_message)(char*)) {
+  char log_msg[256];
+  char entry[64];
+  memset(topicFilterIndex, NO_TOPIC_FILTER, sizeof(topicFilterIndex));
+  topicFilterCount = 0;
+  while ((filters != NULL) && (*filters != '\0')) {
+    const char* next = strchr(filters, ',');
+    unsigned int length = (next != NULL) ? (unsigned int)(next - filters) : strlen(filters);
+    if (length >= sizeof(entry)) length = sizeof(entry) - 1;
+    memcpy(entry, filters, length);
+    entry[length] = '\0';
+    filters = (next != NULL) ? next + 1 : NULL;
+
+    char* field = strchr(entry, ':');
+    if (field != NULL) *field++ = '\0';
+    char* name = entry;
+    while (*name == ' ') name++;
+    if (*name == '\0') continue;
+    unsigned int topic = 0;
+    while ((topic < NUMBER_OF_TOPICS) && (strcmp_P(name, topicDescriptors[topic].name) != 0)) topic++;
+    if (topic == NUMBER_OF_TOPICS) {
+      sprintf(log_msg, "Unknown topic in topic filters: %s", name); log_message(log_msg);
+      continue;
+    }
+    if (topicFilterCount == MAX_TOPIC_FILTERS) {
+      sprintf(log_msg, "Too many topic filters, only %d are used", MAX_TOPIC_FILTERS); log_message(log_msg);
       break;
+    }
+
+    topicFilterStruct *filter = &topicFilters[topicFilterCount];
+    *filter = topicFilterStruct();
+    filter->topic = topic;
+    float deadband = (field != NULL) ? atof(field) : 0;
+    switch (pgm_read_byte(&topicDescriptors[topic].type)) { //deadband to the fixed point unit of the topic
+      case TOPIC_TYPE_DEC1:
+        deadband = deadband * 10;
+        break;
+      case TOPIC_TYPE_DEC2:
+        deadband = deadband * 100;
+        break;
+    }
+    filter->deadband = (deadband > 0) ? lroundf(deadband) : 0;
+    field = (field != NULL) ? strchr(field, ':') : NULL;
+    int percent = (field != NULL) ? atoi(++field) : 0;
+    filter->deadbandPercent = (percent < 0) ? 0 : ((percent > 100) ? 100 : percent);
+    field = (field != NULL) ? strchr(field, ':') : NULL;
+    int interval = (field != NULL) ? atoi(++field) : 0;
+    filter->minInterval = (interval < 0) ? 0 : interval;
+    topicFilterCount++;
+    topicFilterIndex[topic] = topicFilterCount;
+    sprintf(log_msg, "Topic filter for %s: deadband %d, %d%%, interval %u seconds", name, (int)filter->deadband, filter->deadbandPercent, filter->minInterval); log_message(log_msg);
+  }
+  return topicFilterCount;
+}
+
+// Check a new value of a filtered topic against the deadband and minimum interval, true when it should be published
+bool topicFilterPublish(topicFilterStruct *filter, int32_t value, bool updatenow) {
+  unsigned long now = millis();
+  if ((updatenow) || (!filter->published)) {
+    filter->lastValue = value;
+    filter->lastTime = now;
+    filter->published = true;
+    filter->pending = false;
+    return true;
+  }
+  int32_t delta = (value > filter->lastValue) ? (value - filter->lastValue) : (filter->lastValue - value);
+  int32_t deadband = filter->deadband;
+  int32_t relative = ((filter->lastValue < 0) ? -filter->lastValue : filter->lastValue) * filter->deadbandPercent / 100;
+  if (relative > deadband) deadband = relative;
+  if ((delta == 0) || (delta <= deadband)) {
+    filter->pending = false;
+    return false;
+  }
+  if ((now - filter->lastTime) < (1000UL * filter->minInterval)) {
+    filter->pending = true; //recheck on the next frames, even when the bytes do not change anymore
+    return false;
+  }
+  filter->lastValue = value;
+  filter->lastTime = now;
+  filter->pending = false;
+  return true;
+}
+
+// Copy the topics which changed since the last call into changed and start again, false when none changed
+bool takeChangedTopics(byte changed[]) {
+  bool anychanged = false;
+  for (unsigned int i = 0 ; i < sizeof(changedTopics) ; i++) {
+    changed[i] = changedTopics[i];
+    anychanged = anychanged || changedTopics[i];
+    changedTopics[i] = 0;
+  }
+  return anychanged;
+}
+
+// Check if a heatpump answer is byte for byte the previous decoded one and no full refresh is due, so decoding
+// it can be skipped. The checksum byte is compared first, it nearly always differs when anything changed.
+bool heatpumpDataUnchanged(char* data) {
+  if ((!lastDataValid) || (millis() > nextalldatatime)) return false;
+  for (unsigned int i = 0 ; i < topicFilterCount ; i++) {
+    if (topicFilters[i].pending) return false; //a held back value may be due now
+  }
+  if (lastData[PANASONICDATASIZE - 1] != (byte)data[PANASONICDATASIZE - 1]) return false;
+  return memcmp(lastData, data, PANASONICDATASIZE) == 0;
+}
+
+// Json message for mqtt, written to the mqtt client in chunks so a large buffer is not needed
+struct mqttJsonStruct {
+  char buffer[MQTT_JSON_CHUNK_SIZE];
+  unsigned int length;
+  unsigned int total;
+  PubSubClient *mqtt_client; // 0 while only measuring the message size
+};
+
+mqttJsonStruct mqttJson;
+
+void mqttJsonAdd(const char* text) {
+  unsigned int len = strlen(text);
+  mqttJson.total += len;
+  if (!mqttJson.mqtt_client) return;
+  while (len > 0) {
+    unsigned int part = MQTT_JSON_CHUNK_SIZE - mqttJson.length;
+    if (part > len) part = len;
+    memcpy(&mqttJson.buffer[mqttJson.length], text, part);
+    mqttJson.length += part;
+    text += part;
+    len -= part;
+    if (mqttJson.length == MQTT_JSON_CHUNK_SIZE) {
+      mqttJson.mqtt_client->write((const uint8_t*)mqttJson.buffer, mqttJson.length);
+      mqttJson.length = 0;
+    }
+  }
+}
+
+void mqttJsonValues(int32_t actData[], byte* topicMask) {
+  char valueText[TOPIC_VALUE_TEXT_SIZE];
+  char topicName[TOPIC_NAME_SIZE];
+  bool first = true;
+  mqttJsonAdd("{");
+  for (unsigned int topic = 0 ; topic < NUMBER_OF_TOPICS ; topic++) {
+    if (!(topicMask[topic >> 3] & (1 << (topic & 7)))) continue;
+    mqttJsonAdd(first ? "\"" : ",\"");
+    mqttJsonAdd(getTopicName(topic, topicName));
+    mqttJsonAdd("\":");
+    formatTopicValue(topic, actData[topic], valueText);
+    if (pgm_read_byte(&topicDescriptors[topic].type) == TOPIC_TYPE_ERROR) { //the only value which is not a number
+      mqttJsonAdd("\"");
+      mqttJsonAdd(valueText);
+      mqttJsonAdd("\"");
+    } else {
+      mqttJsonAdd(valueText);
+    }
+    first = false;
+  }
+  mqttJsonAdd("}");
+}
+
+// Publish the values of the topics in topicMask as one json message, the size is measured first as it has to be known before streaming
+void publishJson(int32_t actData[], byte* topicMask, PubSubClient &mqtt_client, mqttTopicStruct *mqttTopicBase) {
+  mqttJson.mqtt_client = 0;
+  mqttJson.total = 0;
+  mqttJsonValues(actData, topicMask);
+
+  if (mqtt_client.beginPublish(getMqttTopic(mqttTopicBase, mqtt_topic_json), mqttJson.total, MQTT_RETAIN_VALUES)) {
+    mqttJson.mqtt_client = &mqtt_client;
+    mqttJson.length = 0;
+    mqttJsonValues(actData, topicMask);
+    if (mqttJson.length > 0) mqtt_client.write((const uint8_t*)mqttJson.buffer, mqttJson.length);
+    mqtt_client.endPublish();
   }
-  return String(Error_string);  
 }
 
 // Decode ////////////////////////////////////////////////////////////////////////////
-void decode_heatpump_data(char* data, String actData[], PubSubClient &mqtt_client, void (*log_message)(char*), char* mqtt_topic_base, unsigned int updateAllTime) {
+void decode_heatpump_data(char* data, int32_t actData[], PubSubClient &mqtt_client, void (*log_message)(char*), mqttTopicStruct *mqttTopicValues, mqttTopicStruct *mqttTopicBase, unsigned int updateAllTime, bool mqttPublishTopics, byte mqttPublishJson) {
   char log_msg[256];
-  char mqtt_topic[256];
+  char valueText[TOPIC_VALUE_TEXT_SIZE];
+  char topicName[TOPIC_NAME_SIZE];
   bool updatenow = false;
 
   if (millis() > nextalldatatime) {
@@ -164,38 +644,70 @@ void decode_heatpump_data(char* data, String actData[], PubSubClient &mqtt_clien
     nextalldatatime = millis() + (1000 * updateAllTime);
   }
 
+  //mark each byte which differs from the previous frame, compared in blocks of 8 bytes as mostly only a few bytes change
+  bool decodeall = updatenow || (!lastDataValid);
+  bool anychanged = false;
+  for (unsigned int i = 0 ; i < topicFilterCount ; i++) anychanged = anychanged || topicFilters[i].pending;
+  byte changedBytes[(PANASONICDATASIZE + 7) / 8];
+  for (unsigned int block = 0 ; block < (PANASONICDATASIZE + 7) / 8 ; block++) {
+    unsigned int start = block * 8;
+    unsigned int size = ((start + 8) <= PANASONICDATASIZE) ? 8 : (PANASONICDATASIZE - start);
+    changedBytes[block] = 0;
+    if ((!decodeall) && (memcmp(&lastData[start], &data[start], size) == 0)) continue;
+    for (unsigned int i = 0 ; i < size ; i++) {
+      if (lastData[start + i] != (byte)data[start + i]) changedBytes[block] |= (1 << i);
+    }
+    anychanged = true;
+  }
+  memcpy(lastData, data, PANASONICDATASIZE);
+  lastDataValid = true;
+  if ((!decodeall) && (!anychanged)) return; //identical frame, nothing to decode or publish
+
+  byte publishedTopics[(NUMBER_OF_TOPICS + 7) / 8] = { 0 };
+  bool valueChanged = false;
+
   for (unsigned int Topic_Number = 0 ; Topic_Number < NUMBER_OF_TOPICS ; Topic_Number++) {
-    byte Input_Byte;
-    String Topic_Value;
-    switch (Topic_Number) { //switch on topic numbers, some have special needs
-      case 1: 
-        Topic_Value = getPumpFlow(data);
-        break;
-      case 11:
-        Topic_Value = String(word(data[183], data[182]) - 1);
-        break;
-      case 12:
-        Topic_Value = String(word(data[180], data[179]) - 1);
-        break;
-      case 90:
-        Topic_Value = String(word(data[186], data[185]) - 1);
-        break;
-      case 91:
-        Topic_Value = String(word(data[189], data[188]) - 1);
-        break;
-      case 44:
-        Topic_Value = getErrorInfo(data);
-        break;
-      default:
-        Input_Byte = data[topicBytes[Topic_Number]];
-        Topic_Value = topicFunctions[Topic_Number](Input_Byte);
-        break;
+    byte filterIndex = topicFilterIndex[Topic_Number];
+    bool filterPending = (filterIndex != NO_TOPIC_FILTER) && topicFilters[filterIndex - 1].pending;
+    if ((!decodeall) && (!filterPending) && (!topicBytesChanged(Topic_Number, changedBytes))) continue; //source bytes did not change so the value is the same as in actData
+    int32_t Topic_Value = decodeTopic(Topic_Number, data);
+    bool publish;
+    if (filterIndex == NO_TOPIC_FILTER) {
+      publish = (updatenow) || (actData[Topic_Number] != Topic_Value);
+    } else {
+      publish = topicFilterPublish(&topicFilters[filterIndex - 1], Topic_Value, updatenow);
     }
-    if ((updatenow) || ( actData[Topic_Number] != Topic_Value )) {
-      actData[Topic_Number] = Topic_Value;
-      sprintf(log_msg, "received TOP%d %s: %s", Topic_Number, topics[Topic_Number], Topic_Value.c_str()); log_message(log_msg);
-      sprintf(mqtt_topic, "%s/%s/%s", mqtt_topic_base, mqtt_topic_values, topics[Topic_Number]); mqtt_client.publish(mqtt_topic, Topic_Value.c_str(), MQTT_RETAIN_VALUES);
+    if (actData[Topic_Number] != Topic_Value) {
+      valueChanged = true;
+      changedTopics[Topic_Number >> 3] |= (1 << (Topic_Number & 7));
     }
+    actData[Topic_Number] = Topic_Value;
+    if (publish) {
+      formatTopicValue(Topic_Number, Topic_Value, valueText);
+      getTopicName(Topic_Number, topicName);
+      //"received TOP%d %s: %s" without printf, this runs for every published value
+      strcpy(log_msg, "received TOP");
+      char* log_end = formatUnsigned(Topic_Number, &log_msg[strlen(log_msg)]);
+      *log_end++ = ' ';
+      strcpy(log_end, topicName);
+      strcat(log_end, ": ");
+      strcat(log_end, valueText);
+      log_message(log_msg);
+      if (mqttPublishTopics) {
+        mqtt_client.publish(getMqttTopic(mqttTopicValues, topicName), valueText, MQTT_RETAIN_VALUES);
+      }
+      publishedTopics[Topic_Number >> 3] |= (1 << (Topic_Number & 7));
+    }
+  }
+  if (valueChanged) dataChanged(DATA_HEATPUMP);
+
+  if (mqttPublishJson == MQTT_JSON_ALL) {
+    memset(publishedTopics, 0xFF, sizeof(publishedTopics));
+    publishJson(actData, publishedTopics, mqtt_client, mqttTopicBase);
+  } else if (mqttPublishJson == MQTT_JSON_CHANGED) {
+    bool anypublished = false;
+    for (unsigned int i = 0 ; i < sizeof(publishedTopics) ; i++) anypublished = anypublished || publishedTopics[i];
+    if (anypublished) publishJson(actData, publishedTopics, mqtt_client, mqttTopicBase);
   }
 
 }
@@ -0,0 +1,116 @@
+#include "frameparser.h"
+
+// Streaming parser for the heatpump serial protocol. Received bytes go into a ring buffer, the parser
+// looks for a header (0x71 or 0xF1), checks the length field and keeps a running checksum while the
+// frame comes in. A bad header, length or checksum only skips a single byte so the next frame in the
+// stream is found again without waiting for a timeout. Bytes after a complete frame are kept.
+
+static bool isFrameHeader(byte value) {
+  return (value == 0x71) || (value == 0xF1);
+}
+
+static byte frameParserAt(frameParserStruct *parser, unsigned int offset) {
+  return parser->buffer[(byte)(parser->head + offset)];
+}
+
+// drop bytes from the start of the buffer and restart the candidate frame
+static void frameParserDrop(frameParserStruct *parser, unsigned int bytes) {
+  parser->head += bytes;
+  parser->count -= bytes;
+  parser->checked = 0;
+  parser->checksum = 0;
+}
+
+void frameParserReset(frameParserStruct *parser) {
+  parser->head = 0;
+  parser->count = 0;
+  parser->checked = 0;
+  parser->checksum = 0;
+  parser->skipped = 0;
+  parser->headers = 0;
+}
+
+// A command was sent, the next header should be the start of its answer
+void frameParserExpectAnswer(frameParserStruct *parser) {
+  parser->headers = 0;
+}
+
+// The frame of the last FRAME_OK or FRAME_BAD_CHECKSUM started at the first header after the send. A later
+// bad checksum can be a false header found while resyncing, with the real answer still coming in.
+bool frameParserFirstHeader(frameParserStruct *parser) {
+  return parser->headers == 1;
+}
+
+// Add a received byte, returns false if the buffer overflowed and the oldest byte was dropped
+bool frameParserPush(frameParserStruct *parser, byte value) {
+  bool overflow = false;
+  if (parser->count == FRAMEPARSERBUFFERSIZE) {
+    frameParserDrop(parser, 1);
+    parser->overflows++;
+    overflow = true;
+  }
+  parser->buffer[(byte)(parser->head + parser->count)] = value;
+  parser->count++;
+  return !overflow;
+}
+
+// Scan the buffered bytes, returns one of the FRAME_ results. On FRAME_OK the frame is copied to frame
+// (at least FRAMEPARSERMAXFRAMESIZE bytes) and its length to frame_length. Call again until FRAME_INCOMPLETE
+// is returned to handle all buffered bytes.
+byte frameParserParse(frameParserStruct *parser, char *frame, byte *frame_length) {
+  //scan for a header
+  while ((parser->count > 0) && (!isFrameHeader(frameParserAt(parser, 0)))) {
+    frameParserDrop(parser, 1);
+    parser->skipped++;
+    parser->skippedBytes++;
+  }
+  if (parser->skipped > 0) {
+    parser->skipped = 0;
+    return FRAME_SKIPPED;
+  }
+  if (parser->count < 2) return FRAME_INCOMPLETE;
+
+  unsigned int length = frameParserAt(parser, 1) + 3; //header, length field and checksum
+  if ((length > FRAMEPARSERMAXFRAMESIZE) || (length < FRAMEPARSERMINFRAMESIZE)) {
+    frameParserDrop(parser, 1);
+    parser->headers++;
+    parser->badLengths++;
+    return FRAME_BAD_LENGTH;
+  }
+
+  //add the bytes which came in since the last call to the running checksum
+  while ((parser->checked < parser->count) && (parser->checked < length)) {
+    parser->checksum += frameParserAt(parser, parser->checked);
+    parser->checked++;
+  }
+  if (parser->checked < length) return FRAME_INCOMPLETE;
+
+  parser->headers++;
+  if (parser->checksum != 0) { //all bytes including the checksum byte should add up to 0
+    frameParserDrop(parser, 1);
+    parser->badChecksums++;
+    return FRAME_BAD_CHECKSUM;
+  }
+
+  for (unsigned int i = 0 ; i < length ; i++) {
+    frame[i] = frameParserAt(parser, i);
+  }
+  *frame_length = length;
+  frameParserDrop(parser, length);
+  parser->framesOk++;
+  return FRAME_OK;
+}
+
+// Number of bytes waiting in the buffer
+unsigned int frameParserPending(frameParserStruct *parser) {
+  return parser->count;
+}
+
+// Copy the waiting bytes to buffer (for a hexdump), returns the number of bytes copied
+unsigned int frameParserCopyPending(frameParserStruct *parser, char *buffer, unsigned int size) {
+  unsigned int i = 0;
+  for (; (i < parser->count) && (i < size) ; i++) {
+    buffer[i] = frameParserAt(parser, i);
+  }
+  return i;
+}
@@ -0,0 +1,42 @@
+#ifndef FRAMEPARSER_H
+#define FRAMEPARSER_H
+
+#include <Arduino.h>
+
+#define FRAMEPARSERBUFFERSIZE 256 // ring buffer size, byte indexes wrap around by themselves
+#define FRAMEPARSERMAXFRAMESIZE 255 // a frame must fit in the data buffer in HeishaMon.ino (MAXDATASIZE)
+#define FRAMEPARSERMINFRAMESIZE 4 // header, length, at least one byte and the checksum
+
+//results of frameParserParse
+#define FRAME_INCOMPLETE 0 // need more bytes
+#define FRAME_OK 1 // a complete frame with a valid checksum is copied to the output buffer
+#define FRAME_BAD_CHECKSUM 2 // a complete frame had a bad checksum, it is skipped and scanning resumes after its header
+#define FRAME_BAD_LENGTH 3 // the length field of a header is out of range, scanning resumes after its header
+#define FRAME_SKIPPED 4 // bytes before a valid header were skipped
+
+struct frameParserStruct {
+  byte buffer[FRAMEPARSERBUFFERSIZE];
+  byte head = 0; // first byte of the current (candidate) frame
+  unsigned int count = 0; // number of bytes in the ring buffer
+  unsigned int checked = 0; // number of bytes of the candidate frame added to the running checksum
+  byte checksum = 0; // running checksum of the candidate frame
+  unsigned int skipped = 0; // bytes skipped during the last scan for a header
+  unsigned int headers = 0; // headers checked since frameParserExpectAnswer, only the first can be the start of the answer
+
+  //statistics
+  unsigned long framesOk = 0;
+  unsigned long badChecksums = 0;
+  unsigned long badLengths = 0;
+  unsigned long skippedBytes = 0;
+  unsigned long overflows = 0;
+};
+
+void frameParserReset(frameParserStruct *parser);
+bool frameParserPush(frameParserStruct *parser, byte value);
+byte frameParserParse(frameParserStruct *parser, char *frame, byte *frame_length);
+void frameParserExpectAnswer(frameParserStruct *parser);
+bool frameParserFirstHeader(frameParserStruct *parser);
+unsigned int frameParserPending(frameParserStruct *parser);
+unsigned int frameParserCopyPending(frameParserStruct *parser, char *buffer, unsigned int size);
+
+#endif
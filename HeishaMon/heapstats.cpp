@@ -0,0 +1,48 @@
+#include "heapstats.h"
+
+// Heap fragmentation and the Strings that cause it. The free heap is sampled each loop and while a
+// tracked String is alive, so the minimum is the low point including the String temporaries. The
+// largest free block walks the free list, so it is only sampled at the tracked Strings and when published.
+
+static const char *heapSiteNames[NUMBER_OF_HEAP_SITES] = { "web", "dallas", "s0" };
+
+//global heap statistics, like the s0 and 1wire data they belong to this module
+heapStatsStruct heapStats;
+
+void heapStatsSample(bool maxFreeBlock) {
+  uint32_t freeHeap = ESP.getFreeHeap();
+  if (freeHeap < heapStats.minFreeHeap) heapStats.minFreeHeap = freeHeap;
+  if (maxFreeBlock) {
+    uint32_t freeBlock = ESP.getMaxFreeBlockSize();
+    if (freeBlock < heapStats.minMaxFreeBlock) heapStats.minMaxFreeBlock = freeBlock;
+  }
+}
+
+// Count a String built at site, returns the String so it can wrap the call that builds it
+const String &heapTrackString(byte site, const String &string) {
+  unsigned int size = string.length() + 1;
+  heapStats.sites[site].strings++;
+  heapStats.sites[site].bytes += size;
+  if (size > heapStats.sites[site].largest) heapStats.sites[site].largest = size;
+  heapStatsSample(true);
+  return string;
+}
+
+heapStatsStruct *getHeapStats() {
+  return &heapStats;
+}
+
+const char *getHeapSiteName(byte site) {
+  return heapSiteNames[site];
+}
+
+unsigned int heapStatsJson(char *buffer, unsigned int size) {
+  heapStatsSample(true);
+  unsigned int length = snprintf(buffer, size, "{\"free_heap\":%u,\"max_free_block\":%u,\"fragmentation\":%u,\"min_free_heap\":%u,\"min_max_free_block\":%u",
+                                 ESP.getFreeHeap(), ESP.getMaxFreeBlockSize(), ESP.getHeapFragmentation(), heapStats.minFreeHeap, heapStats.minMaxFreeBlock);
+  for (byte site = 0 ; site < NUMBER_OF_HEAP_SITES ; site++) {
+    if (length < size) length += snprintf(buffer + length, size - length, ",\"%s\":{\"strings\":%lu,\"bytes\":%lu,\"largest\":%u}", heapSiteNames[site], heapStats.sites[site].strings, heapStats.sites[site].bytes, heapStats.sites[site].largest);
+  }
+  if (length < size) length += snprintf(buffer + length, size - length, "}");
+  return (length < size) ? length : size - 1;
+}
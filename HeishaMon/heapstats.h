@@ -0,0 +1,34 @@
+#ifndef HEAPSTATS_H
+#define HEAPSTATS_H
+
+#include <Arduino.h>
+
+//places where web responses are built as Strings, the finished Strings are counted for each of them. That is
+//not every heap allocation: a String built by concatenation reallocates on the way, and the mqtt publish
+//paths build no Strings (they format into fixed buffers), so they are not a site
+#define HEAP_SITE_WEB 0 // status page and value table
+#define HEAP_SITE_DALLAS 1 // 1wire table
+#define HEAP_SITE_S0 2 // s0 table
+#define NUMBER_OF_HEAP_SITES 3
+
+#define HEAPSTATSJSONSIZE 512
+
+struct heapSiteStruct {
+  unsigned long strings = 0; // finished Strings, not the allocations made while building them
+  unsigned long bytes = 0; // their bytes including the terminating zero
+  unsigned int largest = 0; // largest String in bytes
+};
+
+struct heapStatsStruct {
+  uint32_t minFreeHeap = 0xFFFFFFFF; // lowest free heap since boot
+  uint32_t minMaxFreeBlock = 0xFFFFFFFF; // lowest largest free block since boot
+  heapSiteStruct sites[NUMBER_OF_HEAP_SITES];
+};
+
+void heapStatsSample(bool maxFreeBlock);
+const String &heapTrackString(byte site, const String &string);
+heapStatsStruct *getHeapStats(void);
+const char *getHeapSiteName(byte site);
+unsigned int heapStatsJson(char *buffer, unsigned int size);
+
+#endif
@@ -6,7 +6,7 @@ static const char webHeader[] PROGMEM  =
   "<link rel=\"stylesheet\" href=\"https://www.w3schools.com/w3css/4/w3.css\">"
   "<link rel=\"stylesheet\" href=\"https://www.w3schools.com/w3css/4/w3pro.css\">"
   "<link rel=\"stylesheet\" href=\"https://www.w3schools.com/lib/w3-theme-red.css\">"
-  "<link rel=\"stylesheet\" href=\"https://www.w3schools.com/w3css/4/w3.css\">"
+  "<script src=\"" WEBSTATIC_JS_URL "\" defer></script>"
   "<style>"
   "  .w3-btn { margin-bottom:10px; }"
   "</style>";
@@ -18,57 +18,9 @@ static const char webBodyStart[] PROGMEM =
   "<header class=\"w3-container w3-card w3-theme\"><h1>Heisha monitor</h1></header>";
 
 static const char webFooter[] PROGMEM  = "</body></html>";
-static const char menuJS[] PROGMEM =
-  "<script>"
-  "  function openLeftMenu() {"
-  "   var x = document.getElementById(\"leftMenu\");"
-  "   if (x.style.display === \"none\") {"
-  "     x.style.display = \"block\";"
-  "   } else {"
-  "     x.style.display = \"none\";"
-  "   }"
-  " }"
-  "</script>";
-
+// the scripts themselves are in the gzipped WEBSTATIC_JS_URL, only the root page needs jquery for them
 static const char refreshJS[] PROGMEM =
-  "<script src=\"https://ajax.googleapis.com/ajax/libs/jquery/3.4.1/jquery.min.js\"></script>"
-  "<script>"
-  " $(document).ready(function(){refreshTable();});"
-  " function refreshTable(){"
-  "   $('#heishavalues').load('/tablerefresh', function(){setTimeout(refreshTable, 30000);});"
-  "   $('#dallasvalues').load('/tablerefresh?1wire', function(){});"
-  "   $('#s0values').load('/tablerefresh?s0', function(){});"
-  " }"
-  "</script>";
-
-static const char selectJS[] PROGMEM =
-  "<script>"
-  "function openTable(tableName) {"
-  "  var i;"
-  "  var x = document.getElementsByClassName(\"heishatable\");"
-  "  for (i = 0; i < x.length; i++) {"
-  "    x[i].style.display = \"none\";"
-  "  }"
-  "  document.getElementById(tableName).style.display = \"block\";"
-  "}"
-  "</script>";
-
-static const char settingsJS[] PROGMEM =
-  "<script type=\"text/javascript\">"
-  "    function ShowHideDallasTable(dallasEnabled) {"
-  "        var dallassettings = document.getElementById(\"dallassettings\");"
-  "        dallassettings.style.display = dallasEnabled.checked ? \"table\" : \"none\";"
-  "    }"
-  "    function ShowHideS0Table(s0enabled) {"
-  "        var s0settings = document.getElementById(\"s0settings\");"
-  "        s0settings.style.display = s0enabled.checked ? \"table\" : \"none\";"
-  "    }"
-  "    function changeMinWatt(port) {"
-  "        var ppkwh = document.getElementById('s0_ppkwh_'+port).value;"
-  "        var interval = document.getElementById('s0_interval_'+port).value;"
-  "        document.getElementById('s0_minwatt_'+port).innerHTML = Math.round((3600 * 1000 / ppkwh) / interval);"
-  "    }"
-  "</script>";
+  "<script src=\"https://ajax.googleapis.com/ajax/libs/jquery/3.4.1/jquery.min.js\"></script>";
 
 static const char webBodyRoot1[] PROGMEM =
   "<div class=\"w3-sidebar w3-bar-block w3-card w3-animate-left\" style=\"display:none\" id=\"leftMenu\">"
@@ -92,7 +44,13 @@ static const char webBodyEndDiv[] PROGMEM = "</div>";
 static const char webBodyRootStatusWifi[] PROGMEM =   "<div class=\"w3-container w3-left\"><br>Wifi signal: ";
 static const char webBodyRootStatusMemory[] PROGMEM =   "%<br>Memory free: ";
 static const char webBodyRootStatusReceived[] PROGMEM =  "%<br>Correct received data: ";
-static const char webBodyRootStatusUptime[] PROGMEM =   "%<br>Uptime: ";
+static const char webBodyRootStatusSkipped[] PROGMEM =   "%<br>Identical data not decoded: ";
+static const char webBodyRootStatusUptime[] PROGMEM =   "<br>Uptime: ";
+static const char webBodyRootStatusHeap[] PROGMEM =   "<br>Free heap: ";
+static const char webBodyRootStatusTopicTable[] PROGMEM =   " bytes (topic table of ";
+static const char webBodyRootStatusTopicTableEnd[] PROGMEM =   " bytes in flash)";
+static const char webBodyRootStatusLoops[] PROGMEM =   "<br>Loops per second: ";
+static const char webBodyRootStatusLoopStages[] PROGMEM =   "<br>Loop stages (average/max us): ";
 
 static const char webBodyRootHeatpumpValues[] PROGMEM =
   "<div id=\"Heatpump\" class=\"w3-container w3-center heishatable\">"
@@ -0,0 +1,80 @@
+#include "jsonwriter.h"
+
+// Json for the http api, written with the chunk writer so a response needs no Strings. Values are
+// written as they come, the writer only keeps track of the commas. The root is an object.
+
+// The comma before a value and its key, key is 0 for the values in an array
+static void jsonKey(jsonWriterStruct *json, PGM_P key) {
+  if (!json->first[json->depth]) chunkAppendChar(&json->chunk, ',');
+  json->first[json->depth] = false;
+  if (key) {
+    chunkAppendChar(&json->chunk, '"');
+    chunkAppend_P(&json->chunk, key);
+    chunkAppend(&json->chunk, "\":");
+  }
+}
+
+static void jsonOpen(jsonWriterStruct *json, char bracket) {
+  chunkAppendChar(&json->chunk, bracket);
+  if (json->depth < JSONMAXDEPTH) json->depth++;
+  json->first[json->depth] = true;
+}
+
+static void jsonClose(jsonWriterStruct *json, char bracket) {
+  chunkAppendChar(&json->chunk, bracket);
+  if (json->depth > 0) json->depth--;
+}
+
+void jsonBegin(jsonWriterStruct *json, ESP8266WebServer *httpServer) {
+  chunkBegin(&json->chunk, httpServer, "application/json");
+  json->depth = 0;
+  json->first[0] = true;
+  jsonOpen(json, '{');
+}
+
+void jsonObjectBegin(jsonWriterStruct *json, PGM_P key) {
+  jsonKey(json, key);
+  jsonOpen(json, '{');
+}
+
+void jsonObjectEnd(jsonWriterStruct *json) {
+  jsonClose(json, '}');
+}
+
+void jsonArrayBegin(jsonWriterStruct *json, PGM_P key) {
+  jsonKey(json, key);
+  jsonOpen(json, '[');
+}
+
+void jsonArrayEnd(jsonWriterStruct *json) {
+  jsonClose(json, ']');
+}
+
+void jsonString(jsonWriterStruct *json, PGM_P key, const char *value) {
+  jsonKey(json, key);
+  chunkAppendChar(&json->chunk, '"');
+  for (const char *c = value ; *c ; c++) {
+    if ((*c == '"') || (*c == '\\')) {
+      chunkAppendChar(&json->chunk, '\\');
+      chunkAppendChar(&json->chunk, *c);
+    } else if ((byte)*c < 0x20) {
+      char escaped[7];
+      snprintf(escaped, sizeof(escaped), "\\u%04x", *c);
+      chunkAppend(&json->chunk, escaped);
+    } else {
+      chunkAppendChar(&json->chunk, *c);
+    }
+  }
+  chunkAppendChar(&json->chunk, '"');
+}
+
+// value is already formatted as a json number
+void jsonNumber(jsonWriterStruct *json, PGM_P key, const char *value) {
+  jsonKey(json, key);
+  chunkAppend(&json->chunk, value);
+}
+
+void jsonEnd(jsonWriterStruct *json) {
+  jsonClose(json, '}');
+  chunkEnd(&json->chunk);
+}
@@ -0,0 +1,24 @@
+#ifndef JSONWRITER_H
+#define JSONWRITER_H
+
+#include "chunkwriter.h"
+
+#define JSONMAXDEPTH 4 // nesting of objects and arrays
+
+// Writes json straight into a chunked http response, keys are in flash
+struct jsonWriterStruct {
+  chunkWriterStruct chunk;
+  byte depth = 0;
+  bool first[JSONMAXDEPTH + 1]; // nothing written yet in the object or array at this depth
+};
+
+void jsonBegin(jsonWriterStruct *json, ESP8266WebServer *httpServer);
+void jsonObjectBegin(jsonWriterStruct *json, PGM_P key);
+void jsonObjectEnd(jsonWriterStruct *json);
+void jsonArrayBegin(jsonWriterStruct *json, PGM_P key);
+void jsonArrayEnd(jsonWriterStruct *json);
+void jsonString(jsonWriterStruct *json, PGM_P key, const char *value);
+void jsonNumber(jsonWriterStruct *json, PGM_P key, const char *value);
+void jsonEnd(jsonWriterStruct *json);
+
+#endif
@@ -0,0 +1,103 @@
+#include "logring.h"
+
+// Log messages are kept in a ring of bytes, each as a header (length, level, millis) and the text without
+// terminator. Logging only copies into the ring, so it can be done from the serial and decode paths. The
+// messages are drained to mqtt and serial1 from loop() in small batches, and the ring is kept as history
+// for the http log page until the space is needed for new messages.
+
+#define LOGHEADERSIZE 7 // 2 bytes length, 1 byte level, 4 bytes millis
+
+static const char *logLevelNames[NUMBER_OF_LOG_LEVELS] = { "ERROR", "WARNING", "INFO", "DEBUG" };
+
+static void logRingWrite(logRingStruct *ring, const void *data, unsigned int length) {
+  const byte *bytes = (const byte *)data;
+  for (unsigned int i = 0 ; i < length ; i++) {
+    ring->buffer[ring->head] = bytes[i];
+    ring->head = (ring->head + 1) % LOGRINGSIZE;
+  }
+}
+
+static unsigned int logRingCopy(logRingStruct *ring, unsigned int position, void *data, unsigned int length) {
+  byte *bytes = (byte *)data;
+  for (unsigned int i = 0 ; i < length ; i++) {
+    bytes[i] = ring->buffer[position];
+    position = (position + 1) % LOGRINGSIZE;
+  }
+  return position;
+}
+
+static uint16_t logRingLength(logRingStruct *ring, unsigned int position) {
+  uint16_t length;
+  logRingCopy(ring, position, &length, sizeof(length));
+  return length;
+}
+
+// Overwrite the oldest message, it is dropped if it was not drained yet
+static void logRingRemove(logRingStruct *ring) {
+  unsigned int size = LOGHEADERSIZE + logRingLength(ring, ring->tail);
+  if ((ring->pending > 0) && (ring->drain == ring->tail)) {
+    ring->drain = (ring->drain + size) % LOGRINGSIZE;
+    ring->pending--;
+    ring->dropped++;
+  }
+  ring->tail = (ring->tail + size) % LOGRINGSIZE;
+  ring->used -= size;
+  ring->count--;
+}
+
+void logRingAdd(logRingStruct *ring, byte level, const char *text) {
+  uint16_t length = strlen(text);
+  if (length > LOGENTRYSIZE - 1) length = LOGENTRYSIZE - 1;
+  uint32_t time = millis();
+  while (ring->used + LOGHEADERSIZE + length > LOGRINGSIZE) logRingRemove(ring);
+  if (ring->pending == 0) ring->drain = ring->head;
+  logRingWrite(ring, &length, sizeof(length));
+  logRingWrite(ring, &level, sizeof(level));
+  logRingWrite(ring, &time, sizeof(time));
+  logRingWrite(ring, text, length);
+  ring->used += LOGHEADERSIZE + length;
+  ring->count++;
+  ring->pending++;
+  if (level < NUMBER_OF_LOG_LEVELS) ring->logged[level]++;
+}
+
+// Read the message at position, returns the position of the next message
+unsigned int logRingRead(logRingStruct *ring, unsigned int position, logEntryStruct *entry) {
+  uint16_t length;
+  uint32_t time;
+  position = logRingCopy(ring, position, &length, sizeof(length));
+  position = logRingCopy(ring, position, &entry->level, sizeof(entry->level));
+  position = logRingCopy(ring, position, &time, sizeof(time));
+  position = logRingCopy(ring, position, entry->text, length);
+  entry->text[length] = '\0';
+  entry->time = time;
+  return position;
+}
+
+// Next message to send to mqtt and serial1, false when there is none or the batch is done
+bool logRingDrain(logRingStruct *ring, logEntryStruct *entry) {
+  if (ring->pending == 0) {
+    ring->batch = 0;
+    return false;
+  }
+  if ((long)(millis() - ring->nextDrain) < 0) return false;
+  if (ring->batch == LOGDRAINBATCH) {
+    ring->batch = 0;
+    ring->nextDrain = millis() + LOGDRAININTERVAL;
+    return false;
+  }
+  ring->batch++;
+  return logRingNext(ring, entry);
+}
+
+// Next message to send without waiting for the batch, to flush the ring before a reboot
+bool logRingNext(logRingStruct *ring, logEntryStruct *entry) {
+  if (ring->pending == 0) return false;
+  ring->drain = logRingRead(ring, ring->drain, entry);
+  ring->pending--;
+  return true;
+}
+
+const char *getLogLevelName(byte level) {
+  return (level < NUMBER_OF_LOG_LEVELS) ? logLevelNames[level] : "";
+}
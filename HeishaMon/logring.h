@@ -0,0 +1,45 @@
+#ifndef LOGRING_H
+#define LOGRING_H
+
+#include <Arduino.h>
+
+//severity of a log message
+#define LOG_ERROR 0
+#define LOG_WARNING 1
+#define LOG_INFO 2
+#define LOG_DEBUG 3 // only kept in the ring, not published on mqtt
+#define NUMBER_OF_LOG_LEVELS 4
+
+#define LOGRINGSIZE 2048 // bytes for the messages and their headers, the oldest messages are overwritten
+#define LOGENTRYSIZE 512 // longer messages are truncated
+#define LOGDRAINBATCH 4 // messages sent to mqtt and serial1 at once
+#define LOGDRAININTERVAL 50 // millis between two batches
+
+struct logEntryStruct {
+  unsigned long time; // millis when it was logged
+  byte level;
+  char text[LOGENTRYSIZE];
+};
+
+struct logRingStruct {
+  byte buffer[LOGRINGSIZE];
+  unsigned int head = 0; // where the next message is written
+  unsigned int tail = 0; // oldest message
+  unsigned int drain = 0; // oldest message not drained yet
+  unsigned int used = 0; // bytes in use
+  unsigned int count = 0; // messages in the ring
+  unsigned int pending = 0; // messages not drained yet
+  byte batch = 0; // messages drained in this batch
+  unsigned long nextDrain = 0; // millis
+
+  unsigned long logged[NUMBER_OF_LOG_LEVELS] = { 0 }; // since boot
+  unsigned long dropped = 0; // overwritten before they were drained
+};
+
+void logRingAdd(logRingStruct *ring, byte level, const char *text);
+unsigned int logRingRead(logRingStruct *ring, unsigned int position, logEntryStruct *entry);
+bool logRingDrain(logRingStruct *ring, logEntryStruct *entry);
+bool logRingNext(logRingStruct *ring, logEntryStruct *entry);
+const char *getLogLevelName(byte level);
+
+#endif
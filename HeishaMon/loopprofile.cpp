@@ -0,0 +1,62 @@
+#include "loopprofile.h"
+
+// Time spent in each stage of loop(). Each stage adds the micros since the end of the previous stage, so
+// the stages together cover the whole loop. The cumulative and worst case times are measured over a window
+// of LOOPPROFILEWINDOW, which ends at a loop boundary, after which they are kept as the last measurement for
+// publishing.
+
+static const char *loopStageNames[NUMBER_OF_LOOP_STAGES] = { "ota", "http", "mdns", "mqtt", "serial", "bus", "dallas", "s0", "housekeeping", "log" };
+
+void loopProfileStart(loopProfileStruct *profile) {
+  profile->loopStart = micros();
+  profile->stageStart = profile->loopStart;
+}
+
+// The stage has just finished
+void loopProfileStage(loopProfileStruct *profile, byte stage) {
+  unsigned long now = micros();
+  unsigned long elapsed = now - profile->stageStart;
+  profile->stages[stage].time += elapsed;
+  if (elapsed > profile->stages[stage].max) profile->stages[stage].max = elapsed;
+  profile->stageStart = now;
+}
+
+void loopProfileEnd(loopProfileStruct *profile) {
+  profile->loopTime = micros() - profile->loopStart;
+  if (profile->loopTime > profile->loopMax) profile->loopMax = profile->loopTime;
+  if (profile->loopTime > profile->loopMaxTotal) profile->loopMaxTotal = profile->loopTime;
+  profile->loops++;
+  profile->loopsTotal++;
+}
+
+// Called after loopProfileEnd, when the window has passed keep the measurement as the last measurement and start a new one
+void loopProfileMeasure(loopProfileStruct *profile) {
+  unsigned long now = millis();
+  unsigned long period = now - profile->measureStart;
+  if (period < LOOPPROFILEWINDOW) return;
+  for (byte stage = 0 ; stage < NUMBER_OF_LOOP_STAGES ; stage++) {
+    profile->lastStages[stage] = profile->stages[stage];
+    profile->stages[stage].time = 0;
+    profile->stages[stage].max = 0;
+  }
+  profile->lastLoops = profile->loops;
+  profile->lastLoopMax = profile->loopMax;
+  profile->loopsPerSecond = (period > 0) ? (uint64_t)profile->loops * 1000 / period : 0;
+  profile->loops = 0;
+  profile->loopMax = 0;
+  profile->measureStart = now;
+}
+
+const char *getLoopStageName(byte stage) {
+  return loopStageNames[stage];
+}
+
+// The last measurement, per stage the cumulative micros and the longest run
+unsigned int loopProfileJson(loopProfileStruct *profile, char *buffer, unsigned int size) {
+  unsigned int length = snprintf(buffer, size, "{\"loops\":%lu,\"loops_per_sec\":%lu,\"loop_max_us\":%lu", profile->lastLoops, profile->loopsPerSecond, profile->lastLoopMax);
+  for (byte stage = 0 ; stage < NUMBER_OF_LOOP_STAGES ; stage++) {
+    if (length < size) length += snprintf(buffer + length, size - length, ",\"%s\":{\"total_us\":%lu,\"max_us\":%lu}", loopStageNames[stage], profile->lastStages[stage].time, profile->lastStages[stage].max);
+  }
+  if (length < size) length += snprintf(buffer + length, size - length, "}");
+  return (length < size) ? length : size - 1;
+}
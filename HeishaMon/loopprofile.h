@@ -0,0 +1,54 @@
+#ifndef LOOPPROFILE_H
+#define LOOPPROFILE_H
+
+#include <Arduino.h>
+
+//stages of loop(), in the order they run
+#define LOOP_STAGE_OTA 0
+#define LOOP_STAGE_HTTP 1
+#define LOOP_STAGE_MDNS 2
+#define LOOP_STAGE_MQTT 3
+#define LOOP_STAGE_SERIAL 4 // reading the answer of the heatpump
+#define LOOP_STAGE_BUS 5 // bus scheduler and sending commands and queries
+#define LOOP_STAGE_DALLAS 6
+#define LOOP_STAGE_S0 7
+#define LOOP_STAGE_HOUSEKEEPING 8
+#define LOOP_STAGE_LOG 9 // sending the log to mqtt and serial1
+#define NUMBER_OF_LOOP_STAGES 10
+
+#define LOOPPROFILEWINDOW 5000 // millis per measurement, the shortest housekeeping period
+#define LOOPPROFILEJSONSIZE 640
+
+struct loopStageStruct {
+  unsigned long time = 0; // micros spent in the stage during the measurement
+  unsigned long max = 0; // longest run of the stage in micros during the measurement
+};
+
+struct loopProfileStruct {
+  //measurement in progress
+  loopStageStruct stages[NUMBER_OF_LOOP_STAGES];
+  unsigned long loops = 0;
+  unsigned long loopMax = 0; // longest loop in micros
+  unsigned long measureStart = 0; // millis
+  unsigned long loopStart = 0; // micros
+  unsigned long stageStart = 0; // micros
+
+  //last complete measurement
+  loopStageStruct lastStages[NUMBER_OF_LOOP_STAGES];
+  unsigned long lastLoops = 0;
+  unsigned long lastLoopMax = 0;
+  unsigned long loopsPerSecond = 0;
+
+  unsigned long loopTime = 0; // micros of the last loop
+  unsigned long loopsTotal = 0; // since boot
+  unsigned long loopMaxTotal = 0; // since boot
+};
+
+void loopProfileStart(loopProfileStruct *profile);
+void loopProfileStage(loopProfileStruct *profile, byte stage);
+void loopProfileEnd(loopProfileStruct *profile);
+void loopProfileMeasure(loopProfileStruct *profile);
+const char *getLoopStageName(byte stage);
+unsigned int loopProfileJson(loopProfileStruct *profile, char *buffer, unsigned int size);
+
+#endif
@@ -0,0 +1,66 @@
+#include "metrics.h"
+
+// Text exposition format for Prometheus, written with the chunk writer so there is no String building
+// and the heap use does not depend on the number of metrics. Names, types, help texts and labels are
+// kept in flash.
+
+void metricsBegin(chunkWriterStruct *writer, ESP8266WebServer *httpServer) {
+  chunkBegin(writer, httpServer, "text/plain; version=0.0.4");
+}
+
+// # HELP and # TYPE lines, once before the values of a metric
+void metricsFamily(chunkWriterStruct *writer, PGM_P name, byte type, PGM_P help) {
+  chunkAppend(writer, "# HELP ");
+  chunkAppend_P(writer, name);
+  chunkAppend(writer, " ");
+  chunkAppend_P(writer, help);
+  chunkAppend(writer, "\n# TYPE ");
+  chunkAppend_P(writer, name);
+  chunkAppend(writer, (type == METRIC_COUNTER) ? " counter\n" : " gauge\n");
+}
+
+// name{labels} value, labels is 0 or the text between the braces (in ram, it is usually formatted)
+void metricsValue(chunkWriterStruct *writer, PGM_P name, const char *labels, unsigned long value) {
+  chunkAppend_P(writer, name);
+  if (labels) {
+    chunkAppend(writer, "{");
+    chunkAppend(writer, labels);
+    chunkAppend(writer, "}");
+  }
+  chunkAppend(writer, " ");
+  chunkAppendUnsigned(writer, value);
+  chunkAppend(writer, "\n");
+}
+
+// name{label="labelValue"} value, for numbered things like the s0 ports
+void metricsLabelValue(chunkWriterStruct *writer, PGM_P name, PGM_P label, unsigned int labelValue, unsigned long value) {
+  chunkAppend_P(writer, name);
+  chunkAppend(writer, "{");
+  chunkAppend_P(writer, label);
+  chunkAppend(writer, "=\"");
+  chunkAppendUnsigned(writer, labelValue);
+  chunkAppend(writer, "\"} ");
+  chunkAppendUnsigned(writer, value);
+  chunkAppend(writer, "\n");
+}
+
+// a metric without labels, with its # HELP and # TYPE lines
+void metricsSingle(chunkWriterStruct *writer, PGM_P name, byte type, PGM_P help, unsigned long value) {
+  metricsFamily(writer, name, type, help);
+  metricsValue(writer, name, 0, value);
+}
+
+// a metric without labels for a fractional value, value is fixed point with decimals (1 or 2), so 90 with 2 decimals is 0.90
+void metricsSingleDecimal(chunkWriterStruct *writer, PGM_P name, byte type, PGM_P help, int32_t value, byte decimals) {
+  char valueText[16];
+  metricsFamily(writer, name, type, help);
+  chunkAppend_P(writer, name);
+  chunkAppend(writer, " ");
+  formatDecimal(value, decimals, valueText);
+  chunkAppend(writer, valueText);
+  chunkAppend(writer, "\n");
+}
+
+void metricsEnd(chunkWriterStruct *writer) {
+  chunkEnd(writer);
+}
@@ -0,0 +1,20 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "chunkwriter.h"
+#include "publish.h"
+
+#define METRIC_COUNTER 0
+#define METRIC_GAUGE 1
+
+// The Prometheus text format is written straight into a chunked http response
+
+void metricsBegin(chunkWriterStruct *writer, ESP8266WebServer *httpServer);
+void metricsFamily(chunkWriterStruct *writer, PGM_P name, byte type, PGM_P help);
+void metricsValue(chunkWriterStruct *writer, PGM_P name, const char *labels, unsigned long value);
+void metricsLabelValue(chunkWriterStruct *writer, PGM_P name, PGM_P label, unsigned int labelValue, unsigned long value);
+void metricsSingle(chunkWriterStruct *writer, PGM_P name, byte type, PGM_P help, unsigned long value);
+void metricsSingleDecimal(chunkWriterStruct *writer, PGM_P name, byte type, PGM_P help, int32_t value, byte decimals);
+void metricsEnd(chunkWriterStruct *writer);
+
+#endif
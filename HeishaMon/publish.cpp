@@ -0,0 +1,59 @@
+#include "publish.h"
+
+// Render "<base>/<subtopic>/" as the prefix of the topic, without a subtopic the prefix is "<base>/"
+void setMqttTopicPrefix(mqttTopicStruct *mqttTopic, const char* mqtt_topic_base, const char* subtopic) {
+  if (subtopic) {
+    snprintf(mqttTopic->topic, MQTT_TOPIC_SIZE, "%s/%s/", mqtt_topic_base, subtopic);
+  } else {
+    snprintf(mqttTopic->topic, MQTT_TOPIC_SIZE, "%s/", mqtt_topic_base);
+  }
+  mqttTopic->prefixLength = strlen(mqttTopic->topic);
+}
+
+// Replace the suffix after the prefix, returns the complete topic
+char* getMqttTopic(mqttTopicStruct *mqttTopic, const char* suffix) {
+  strlcpy(&mqttTopic->topic[mqttTopic->prefixLength], suffix, MQTT_TOPIC_SIZE - mqttTopic->prefixLength);
+  return mqttTopic->topic;
+}
+
+// Same, with a number after the suffix (for example "Watthour/1")
+char* getMqttTopic(mqttTopicStruct *mqttTopic, const char* suffix, unsigned int number) {
+  getMqttTopic(mqttTopic, suffix);
+  unsigned int length = strlen(mqttTopic->topic);
+  if (length + 11 <= MQTT_TOPIC_SIZE) formatUnsigned(number, &mqttTopic->topic[length]);
+  return mqttTopic->topic;
+}
+
+char* formatUnsigned(uint32_t value, char* buffer) {
+  char digits[10];
+  byte count = 0;
+  do {
+    digits[count++] = '0' + (value % 10);
+    value /= 10;
+  } while (value > 0);
+  while (count > 0) *buffer++ = digits[--count];
+  *buffer = '\0';
+  return buffer;
+}
+
+char* formatInteger(int32_t value, char* buffer) {
+  if (value < 0) {
+    *buffer++ = '-';
+    return formatUnsigned(-(uint32_t)value, buffer);
+  }
+  return formatUnsigned(value, buffer);
+}
+
+// Format a fixed point value, value is the number times 10^decimals (decimals 1 or 2, 21.5 with 2 decimals is 2150)
+char* formatDecimal(int32_t value, byte decimals, char* buffer) {
+  uint32_t divider = (decimals == 1) ? 10 : 100;
+  uint32_t absvalue = (value < 0) ? -(uint32_t)value : value;
+  if (value < 0) *buffer++ = '-';
+  buffer = formatUnsigned(absvalue / divider, buffer);
+  *buffer++ = '.';
+  uint32_t fraction = absvalue % divider;
+  if (decimals != 1) *buffer++ = '0' + (fraction / 10);
+  *buffer++ = '0' + (fraction % 10);
+  *buffer = '\0';
+  return buffer;
+}
@@ -0,0 +1,23 @@
+#ifndef PUBLISH_H
+#define PUBLISH_H
+
+#include <Arduino.h>
+
+#define MQTT_TOPIC_SIZE 128 // base (max 39) + subtopic + the longest topic name fits easily
+
+// mqtt topic with a prefix which is rendered once (for example "<base>/sdc/"), each publish only appends its suffix
+struct mqttTopicStruct {
+  char topic[MQTT_TOPIC_SIZE];
+  unsigned int prefixLength;
+};
+
+void setMqttTopicPrefix(mqttTopicStruct *mqttTopic, const char* mqtt_topic_base, const char* subtopic);
+char* getMqttTopic(mqttTopicStruct *mqttTopic, const char* suffix);
+char* getMqttTopic(mqttTopicStruct *mqttTopic, const char* suffix, unsigned int number);
+
+// integer routines to format values without printf, they return a pointer to the terminating zero
+char* formatUnsigned(uint32_t value, char* buffer);
+char* formatInteger(int32_t value, char* buffer);
+char* formatDecimal(int32_t value, byte decimals, char* buffer);
+
+#endif
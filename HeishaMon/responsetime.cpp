@@ -0,0 +1,50 @@
+#include "responsetime.h"
+
+// Rolling histogram of the time from sending a request to receiving its complete answer. The timeout
+// for the next answer is derived from a high percentile of it plus a margin, so a lost answer blocks the
+// bus for a few hundred millis instead of the full RESPONSETIMEMAX. Old answers fade out because the
+// histogram is halved each time it is full. Answers which are later than the timeout are lost, so after
+// a few timeouts in a row the histogram is cleared and the full RESPONSETIMEMAX is used again.
+
+// Upper bound in millis of the bucket holding the percentile of the answers
+unsigned long responseTimePercentile(responseTimeStruct *responseTime, byte percentile) {
+  if (responseTime->samples == 0) return RESPONSETIMEMAX;
+  unsigned long wanted = ((unsigned long)responseTime->samples * percentile + 99) / 100;
+  unsigned long counted = 0;
+  for (byte i = 0 ; i < RESPONSETIMEBUCKETS ; i++) {
+    counted += responseTime->histogram[i];
+    if (counted >= wanted) return (i + 1) * RESPONSETIMEBUCKET;
+  }
+  return RESPONSETIMEMAX;
+}
+
+void responseTimeAdd(responseTimeStruct *responseTime, unsigned long time) {
+  unsigned long bucket = time / RESPONSETIMEBUCKET;
+  if (bucket >= RESPONSETIMEBUCKETS) bucket = RESPONSETIMEBUCKETS - 1;
+  responseTime->histogram[bucket]++;
+  responseTime->samples++;
+  responseTime->timeouts = 0;
+  if (responseTime->samples >= RESPONSETIMEMAXSAMPLES) {
+    responseTime->samples = 0;
+    for (byte i = 0 ; i < RESPONSETIMEBUCKETS ; i++) {
+      responseTime->histogram[i] /= 2;
+      responseTime->samples += responseTime->histogram[i];
+    }
+  }
+  if (responseTime->samples < RESPONSETIMEMINSAMPLES) {
+    responseTime->timeout = RESPONSETIMEMAX;
+  } else {
+    responseTime->timeout = responseTimePercentile(responseTime, RESPONSETIMEPERCENTILE) + RESPONSETIMEMARGIN;
+    if (responseTime->timeout > RESPONSETIMEMAX) responseTime->timeout = RESPONSETIMEMAX;
+  }
+}
+
+void responseTimeTimeout(responseTimeStruct *responseTime) {
+  responseTime->timeouts++;
+  if (responseTime->timeouts >= RESPONSETIMEMAXTIMEOUTS) {
+    memset(responseTime->histogram, 0, sizeof(responseTime->histogram));
+    responseTime->samples = 0;
+    responseTime->timeouts = 0;
+    responseTime->timeout = RESPONSETIMEMAX;
+  }
+}
@@ -0,0 +1,27 @@
+#ifndef RESPONSETIME_H
+#define RESPONSETIME_H
+
+#include <Arduino.h>
+
+#define RESPONSETIMEMAX 2000 // millis, the timeout never gets longer than the old fixed SERIALTIMEOUT
+#define RESPONSETIMEBUCKET 50 // millis per histogram bucket
+#define RESPONSETIMEBUCKETS (RESPONSETIMEMAX / RESPONSETIMEBUCKET) // the last bucket also counts anything slower
+#define RESPONSETIMEPERCENTILE 99 // the timeout covers this percentage of the measured answers
+#define RESPONSETIMEMARGIN 150 // millis added to the percentile
+#define RESPONSETIMEMINSAMPLES 20 // use RESPONSETIMEMAX until this many answers are measured
+#define RESPONSETIMEMAXSAMPLES 200 // halve the histogram when it has this many answers, so it follows changes
+#define RESPONSETIMEGRACE 220 // millis after the timeout that arriving bytes may still postpone it, about one 203 byte frame at 9600 8E1
+#define RESPONSETIMEMAXTIMEOUTS 3 // start measuring again after this many timeouts in a row, the heatpump may have become slower
+
+struct responseTimeStruct {
+  unsigned int histogram[RESPONSETIMEBUCKETS] = { 0 };
+  unsigned int samples = 0;
+  byte timeouts = 0; // timeouts in a row
+  unsigned long timeout = RESPONSETIMEMAX; // millis to wait for an answer
+};
+
+void responseTimeAdd(responseTimeStruct *responseTime, unsigned long time);
+void responseTimeTimeout(responseTimeStruct *responseTime);
+unsigned long responseTimePercentile(responseTimeStruct *responseTime, byte percentile);
+
+#endif
@@ -1,6 +1,8 @@
 #include <PubSubClient.h>
 #include "commands.h"
 #include "s0.h"
+#include "publish.h"
+#include "dataversion.h"
 
 #define MQTT_RETAIN_VALUES 1 // do we retain 1wire values?
 
@@ -25,15 +27,12 @@ ICACHE_RAM_ATTR void onS0Pulse2() {
   new_pulse_s0[1] = millis();
 }
 
-void initS0Sensors(s0SettingsStruct s0Settings[], PubSubClient &mqtt_client, char* mqtt_topic_base) {
-  char mqtt_topic[256];
-
+void initS0Sensors(s0SettingsStruct s0Settings[], PubSubClient &mqtt_client, mqttTopicStruct *mqttTopicS0) {
   //setup s0 port 1
   actS0Settings[0].gpiopin = s0Settings[0].gpiopin;
   actS0Settings[0].ppkwh = s0Settings[0].ppkwh;
   actS0Settings[0].lowerPowerInterval = s0Settings[0].lowerPowerInterval;
-  sprintf(mqtt_topic, "%s/%s/WatthourTotal/1", mqtt_topic_base, mqtt_topic_s0);
-  mqtt_client.subscribe(mqtt_topic);
+  mqtt_client.subscribe(getMqttTopic(mqttTopicS0, "WatthourTotal/", 1));
   pinMode(actS0Settings[0].gpiopin, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(actS0Settings[0].gpiopin), onS0Pulse1, RISING);
   actS0Data[0].nextReport = millis() + MINREPORTEDS0TIME; //initial report after interval, not directly at boot
@@ -45,8 +44,7 @@ void initS0Sensors(s0SettingsStruct s0Settings[], PubSubClient &mqtt_client, cha
   pinMode(actS0Settings[1].gpiopin, INPUT_PULLUP);
   attachInterrupt(digitalPinToInterrupt(actS0Settings[1].gpiopin), onS0Pulse2, RISING);
   actS0Data[1].nextReport = millis() + MINREPORTEDS0TIME; //initial report after interval, not directly at boot
-  sprintf(mqtt_topic, "%s/%s/WatthourTotal/2", mqtt_topic_base, mqtt_topic_s0);
-  mqtt_client.subscribe(mqtt_topic);
+  mqtt_client.subscribe(getMqttTopic(mqttTopicS0, "WatthourTotal/", 2));
 }
 
 void restore_s0_Watthour(int s0Port, float watthour) {
@@ -64,7 +62,18 @@ void s0SettingsCorrupt(s0SettingsStruct s0Settings[], void (*log_message)(char*)
   }
 }
 
-void s0Loop(PubSubClient &mqtt_client, void (*log_message)(char*), char* mqtt_topic_base, s0SettingsStruct s0Settings[]) {
+// Format pulses as Watthour with two decimals, in integers as the total can get larger than a float keeps exact
+char* formatWatthour(unsigned int pulses, unsigned int ppkwh, char* buffer) {
+  uint64_t centiWatthour = ((uint64_t)pulses * 100000 + ppkwh / 2) / ppkwh;
+  char* end = formatUnsigned(centiWatthour / 100, buffer);
+  *end++ = '.';
+  *end++ = '0' + ((centiWatthour % 100) / 10);
+  *end++ = '0' + (centiWatthour % 10);
+  *end = '\0';
+  return buffer;
+}
+
+void s0Loop(PubSubClient &mqtt_client, void (*log_message)(char*), mqttTopicStruct *mqttTopicS0, s0SettingsStruct s0Settings[]) {
 
   //check for corruption
   s0SettingsCorrupt(s0Settings, log_message);
@@ -72,6 +81,9 @@ void s0Loop(PubSubClient &mqtt_client, void (*log_message)(char*), char* mqtt_to
   unsigned long millisThisLoop = millis();
 
   for (int i = 0 ; i < NUM_S0_COUNTERS ; i++) {
+    unsigned int lastWatt = actS0Data[i].watt;
+    unsigned int lastPulses = actS0Data[i].pulses;
+
     //first handle new detected pulses
     noInterrupts();
     unsigned long new_pulse = new_pulse_s0[i];
@@ -107,29 +119,34 @@ void s0Loop(PubSubClient &mqtt_client, void (*log_message)(char*), char* mqtt_to
         }
       }
 
-      float Watthour = (actS0Data[i].pulses * ( 1000.0 / actS0Settings[i].ppkwh));
+      unsigned int pulses = actS0Data[i].pulses;
       actS0Data[i].pulsesTotal = actS0Data[i].pulsesTotal + actS0Data[i].pulses;
       actS0Data[i].pulses = 0; //per message we report new wattHour, so pulses should be zero at start new message
 
 
       //report using mqtt
       char log_msg[256];
-      char mqtt_topic[256];
       char valueStr[20];
-      sprintf(log_msg, "Measured Watthour on S0 port %d: %.2f", (i + 1),  Watthour ); log_message(log_msg);
-      sprintf(valueStr, "%.2f", Watthour);
-      sprintf(mqtt_topic, "%s/%s/Watthour/%d", mqtt_topic_base, mqtt_topic_s0, (i + 1)); mqtt_client.publish(mqtt_topic, valueStr, MQTT_RETAIN_VALUES);
-      float WatthourTotal = (actS0Data[i].pulsesTotal * ( 1000.0 / actS0Settings[i].ppkwh));
-      sprintf(log_msg, "Measured total Watthour on S0 port %d: %.2f", (i + 1),  WatthourTotal ); log_message(log_msg);
-      sprintf(valueStr, "%.2f", WatthourTotal);
-      sprintf(mqtt_topic, "%s/%s/WatthourTotal/%d", mqtt_topic_base, mqtt_topic_s0, (i + 1)); mqtt_client.publish(mqtt_topic, valueStr, MQTT_RETAIN_VALUES);
-      sprintf(log_msg, "Calculated Watt on S0 port %d: %u", (i + 1), actS0Data[i].watt); log_message(log_msg);
-      sprintf(valueStr, "%u",  actS0Data[i].watt);
-      sprintf(mqtt_topic, "%s/%s/Watt/%d", mqtt_topic_base, mqtt_topic_s0, (i + 1)); mqtt_client.publish(mqtt_topic, valueStr, MQTT_RETAIN_VALUES);
+      formatWatthour(pulses, actS0Settings[i].ppkwh, valueStr);
+      sprintf(log_msg, "Measured Watthour on S0 port %d: %s", (i + 1), valueStr); log_message(log_msg);
+      mqtt_client.publish(getMqttTopic(mqttTopicS0, "Watthour/", i + 1), valueStr, MQTT_RETAIN_VALUES);
+      formatWatthour(actS0Data[i].pulsesTotal, actS0Settings[i].ppkwh, valueStr);
+      sprintf(log_msg, "Measured total Watthour on S0 port %d: %s", (i + 1), valueStr); log_message(log_msg);
+      mqtt_client.publish(getMqttTopic(mqttTopicS0, "WatthourTotal/", i + 1), valueStr, MQTT_RETAIN_VALUES);
+      formatUnsigned(actS0Data[i].watt, valueStr);
+      sprintf(log_msg, "Calculated Watt on S0 port %d: %s", (i + 1), valueStr); log_message(log_msg);
+      mqtt_client.publish(getMqttTopic(mqttTopicS0, "Watt/", i + 1), valueStr, MQTT_RETAIN_VALUES);
     }
+
+    if ((actS0Data[i].watt != lastWatt) || (actS0Data[i].pulses != lastPulses)) dataChanged(DATA_S0);
   }
 }
 
+// pulses counted on a port since boot (or since the restored Watthour), including the ones not reported yet
+unsigned long getS0PulsesTotal(int s0Port) {
+  return actS0Data[s0Port].pulsesTotal + actS0Data[s0Port].pulses;
+}
+
 String s0TableOutput() {
   String output = "";
   for (int i = 0; i < NUM_S0_COUNTERS; i++) {
@@ -142,16 +159,17 @@ String s0TableOutput() {
   return output;
 }
 
-String s0JsonOutput() {
-  String output = "[";
+// The s0 ports as objects in the json array which is written
+void s0JsonOutput(jsonWriterStruct *json) {
+  char valueStr[20];
   for (int i = 0; i < NUM_S0_COUNTERS; i++) {
-    output = output + "{";
-    output = output + "\"S0 port\": \"" + (i + 1) + "\",";
-    output = output + "\"Watt\": \"" + actS0Data[i].watt + "\",";
-    output = output + "\"Watthour\": \"" + (actS0Data[i].pulses * ( 1000.0 / actS0Settings[i].ppkwh)) + "\"";
-    output = output + "}";
-    if (i < NUM_S0_COUNTERS - 1) output = output + ",";
+    jsonObjectBegin(json, 0);
+    formatUnsigned(i + 1, valueStr);
+    jsonString(json, PSTR("S0 port"), valueStr);
+    formatUnsigned(actS0Data[i].watt, valueStr);
+    jsonString(json, PSTR("Watt"), valueStr);
+    formatWatthour(actS0Data[i].pulses, actS0Settings[i].ppkwh, valueStr);
+    jsonString(json, PSTR("Watthour"), valueStr);
+    jsonObjectEnd(json);
   }
-  output = output + "]";
-  return output;
 }
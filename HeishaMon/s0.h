@@ -1,4 +1,9 @@
+#ifndef S0_H
+#define S0_H
+
 #include <PubSubClient.h>
+#include "publish.h"
+#include "jsonwriter.h"
 
 #define NUM_S0_COUNTERS 2
 #define DEFAULT_S0_PIN_1 12  // S0_1 pin, for now a static config - should be in config menu later
@@ -20,8 +25,11 @@ struct s0DataStruct {
 };
 
 
-void initS0Sensors(s0SettingsStruct s0Settings[], PubSubClient &mqtt_client, char* mqtt_topic_base);
+void initS0Sensors(s0SettingsStruct s0Settings[], PubSubClient &mqtt_client, mqttTopicStruct *mqttTopicS0);
 void restore_s0_Watthour(int s0Port,float watthour);
-void s0Loop(PubSubClient &mqtt_client, void (*log_message)(char*), char* mqtt_topic_base, s0SettingsStruct s0Settings[]);
+void s0Loop(PubSubClient &mqtt_client, void (*log_message)(char*), mqttTopicStruct *mqttTopicS0, s0SettingsStruct s0Settings[]);
+unsigned long getS0PulsesTotal(int s0Port);
 String s0TableOutput(void);
-String s0JsonOutput(void);
+void s0JsonOutput(jsonWriterStruct *json);
+
+#endif
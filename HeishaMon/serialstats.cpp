@@ -0,0 +1,102 @@
+#include "serialstats.h"
+
+// Timing of every transaction on the serial bus: when the first and the last byte of the answer arrived,
+// the largest gap between two bytes, the number of bytes and how the transaction ended. The last
+// SERIALSTATSWINDOW transactions are kept for min/avg/p95/max, the outcomes are counted since boot.
+
+static const char *serialOutcomeNames[NUMBER_OF_SERIAL_OUTCOMES] = { "ok", "bad_header", "bad_checksum", "timeout", "overflow" };
+static const char *serialMetricNames[NUMBER_OF_SERIAL_METRICS] = { "first_byte_ms", "last_byte_ms", "max_gap_us", "length" };
+
+static uint16_t serialStatsClamp(unsigned long value) {
+  return (value > 65535) ? 65535 : value;
+}
+
+// A request is sent, the answer is measured from now
+void serialStatsStart(serialStatsStruct *stats) {
+  stats->active = true;
+  stats->start = millis();
+  memset(&stats->current, 0, sizeof(stats->current));
+  stats->current.outcome = SERIAL_OUTCOME_OK;
+}
+
+// A byte of the answer is read
+void serialStatsByte(serialStatsStruct *stats) {
+  if (!stats->active) return;
+  unsigned long now = micros();
+  uint16_t elapsed = serialStatsClamp(millis() - stats->start);
+  if (stats->current.metric[SERIAL_METRIC_LENGTH] == 0) {
+    stats->current.metric[SERIAL_METRIC_FIRST_BYTE] = elapsed;
+  } else {
+    uint16_t gap = serialStatsClamp(now - stats->lastByte);
+    if (gap > stats->current.metric[SERIAL_METRIC_MAX_GAP]) stats->current.metric[SERIAL_METRIC_MAX_GAP] = gap;
+  }
+  stats->current.metric[SERIAL_METRIC_LAST_BYTE] = elapsed;
+  if (stats->current.metric[SERIAL_METRIC_LENGTH] < 65535) stats->current.metric[SERIAL_METRIC_LENGTH]++;
+  stats->lastByte = now;
+}
+
+// Millis from sending to the last byte read of the transaction in progress
+unsigned long serialStatsLastByte(serialStatsStruct *stats) {
+  return stats->current.metric[SERIAL_METRIC_LAST_BYTE];
+}
+
+// Something went wrong during the answer, it is the outcome if the answer does not arrive in time
+void serialStatsError(serialStatsStruct *stats, byte outcome) {
+  if (stats->active && (stats->current.outcome == SERIAL_OUTCOME_OK)) stats->current.outcome = outcome;
+}
+
+// The transaction ended with an answer (ok or bad checksum) or with a timeout
+void serialStatsEnd(serialStatsStruct *stats, byte outcome) {
+  if (!stats->active) return;
+  stats->active = false;
+  if ((outcome != SERIAL_OUTCOME_TIMEOUT) || (stats->current.outcome == SERIAL_OUTCOME_OK)) stats->current.outcome = outcome;
+  stats->outcomes[stats->current.outcome]++;
+  stats->window[stats->next] = stats->current;
+  stats->next = (stats->next + 1) % SERIALSTATSWINDOW;
+  if (stats->count < SERIALSTATSWINDOW) stats->count++;
+}
+
+// min/avg/p95/max of a metric over the transactions in the window, timing metrics only count
+// transactions in which an answer was received
+void serialStatsSummary(serialStatsStruct *stats, byte metric, serialStatsSummaryStruct *summary) {
+  uint16_t values[SERIALSTATSWINDOW];
+  byte count = 0;
+  unsigned long sum = 0;
+  for (byte i = 0 ; i < stats->count ; i++) {
+    if ((metric != SERIAL_METRIC_LENGTH) && (stats->window[i].metric[SERIAL_METRIC_LENGTH] == 0)) continue;
+    uint16_t value = stats->window[i].metric[metric];
+    //insertion sort, the window is small
+    byte j = count;
+    while ((j > 0) && (values[j - 1] > value)) {
+      values[j] = values[j - 1];
+      j--;
+    }
+    values[j] = value;
+    count++;
+    sum += value;
+  }
+  if (count == 0) {
+    memset(summary, 0, sizeof(*summary));
+    return;
+  }
+  summary->min = values[0];
+  summary->avg = sum / count;
+  summary->p95 = values[((unsigned int)count * 95 + 99) / 100 - 1];
+  summary->max = values[count - 1];
+}
+
+// {"transactions":32,"first_byte_ms":{"min":..,"avg":..,"p95":..,"max":..},...,"outcomes":{"ok":..,...}}
+unsigned int serialStatsJson(serialStatsStruct *stats, char *buffer, unsigned int size) {
+  unsigned int length = snprintf(buffer, size, "{\"transactions\":%d", stats->count);
+  for (byte metric = 0 ; metric < NUMBER_OF_SERIAL_METRICS ; metric++) {
+    serialStatsSummaryStruct summary;
+    serialStatsSummary(stats, metric, &summary);
+    if (length < size) length += snprintf(buffer + length, size - length, ",\"%s\":{\"min\":%u,\"avg\":%u,\"p95\":%u,\"max\":%u}", serialMetricNames[metric], summary.min, summary.avg, summary.p95, summary.max);
+  }
+  if (length < size) length += snprintf(buffer + length, size - length, ",\"outcomes\":{");
+  for (byte outcome = 0 ; outcome < NUMBER_OF_SERIAL_OUTCOMES ; outcome++) {
+    if (length < size) length += snprintf(buffer + length, size - length, "%s\"%s\":%lu", (outcome > 0) ? "," : "", serialOutcomeNames[outcome], stats->outcomes[outcome]);
+  }
+  if (length < size) length += snprintf(buffer + length, size - length, "}}");
+  return (length < size) ? length : size - 1;
+}
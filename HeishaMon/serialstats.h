@@ -0,0 +1,58 @@
+#ifndef SERIALSTATS_H
+#define SERIALSTATS_H
+
+#include <Arduino.h>
+
+#define SERIALSTATSWINDOW 32 // number of transactions the min/avg/p95/max are calculated over
+#define SERIALSTATSJSONSIZE 640
+
+//outcome of a transaction
+#define SERIAL_OUTCOME_OK 0
+#define SERIAL_OUTCOME_BAD_HEADER 1 // bytes without a valid header or length were skipped
+#define SERIAL_OUTCOME_BAD_CHECKSUM 2
+#define SERIAL_OUTCOME_TIMEOUT 3
+#define SERIAL_OUTCOME_OVERFLOW 4 // the receive buffer was full and bytes were dropped
+#define NUMBER_OF_SERIAL_OUTCOMES 5
+
+//measurements of a transaction
+#define SERIAL_METRIC_FIRST_BYTE 0 // millis from sending to the first byte of the answer
+#define SERIAL_METRIC_LAST_BYTE 1 // millis from sending to the last byte of the answer
+#define SERIAL_METRIC_MAX_GAP 2 // largest time between two bytes of the answer in micros
+#define SERIAL_METRIC_LENGTH 3 // bytes received
+#define NUMBER_OF_SERIAL_METRICS 4
+
+struct serialTransactionStruct {
+  uint16_t metric[NUMBER_OF_SERIAL_METRICS];
+  byte outcome;
+};
+
+struct serialStatsSummaryStruct {
+  uint16_t min;
+  uint16_t avg;
+  uint16_t p95;
+  uint16_t max;
+};
+
+struct serialStatsStruct {
+  serialTransactionStruct window[SERIALSTATSWINDOW];
+  byte next = 0;
+  byte count = 0;
+
+  //transaction in progress
+  bool active = false;
+  unsigned long start = 0; // millis
+  unsigned long lastByte = 0; // micros
+  serialTransactionStruct current;
+
+  unsigned long outcomes[NUMBER_OF_SERIAL_OUTCOMES] = { 0 }; // since boot
+};
+
+void serialStatsStart(serialStatsStruct *stats);
+void serialStatsByte(serialStatsStruct *stats);
+unsigned long serialStatsLastByte(serialStatsStruct *stats);
+void serialStatsError(serialStatsStruct *stats, byte outcome);
+void serialStatsEnd(serialStatsStruct *stats, byte outcome);
+void serialStatsSummary(serialStatsStruct *stats, byte metric, serialStatsSummaryStruct *summary);
+unsigned int serialStatsJson(serialStatsStruct *stats, char *buffer, unsigned int size);
+
+#endif
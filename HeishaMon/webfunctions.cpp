@@ -3,6 +3,7 @@
 #include "webfunctions.h"
 #include "decode.h"
 #include "version.h"
+#include "webstatic.h"
 #include "htmlcode.h"
 #include <LittleFS.h>
 #include "commands.h"
@@ -130,8 +131,12 @@ void setupWifi(DoubleResetDetect &drd, settingsStruct *heishamonSettings) {
             if ( jsonDoc["logHexdump"] == "enabled" ) heishamonSettings->logHexdump = true;
             if ( jsonDoc["logSerial1"] == "disabled" ) heishamonSettings->logSerial1 = false; //default is true so this one is different
             if ( jsonDoc["optionalPCB"] == "enabled" ) heishamonSettings->optionalPCB = true;
+            if ( jsonDoc["mqttPublishTopics"] == "disabled" ) heishamonSettings->mqttPublishTopics = false; //default is true so this one is different
+            if ( jsonDoc["mqttPublishJson"]) heishamonSettings->mqttPublishJson = jsonDoc["mqttPublishJson"];
+            if (heishamonSettings->mqttPublishJson > MQTT_JSON_CHANGED) heishamonSettings->mqttPublishJson = MQTT_JSON_OFF;
+            if ( jsonDoc["topicFilters"] ) strlcpy(heishamonSettings->topicFilters, jsonDoc["topicFilters"], sizeof(heishamonSettings->topicFilters));
             if ( jsonDoc["waitTime"]) heishamonSettings->waitTime = jsonDoc["waitTime"];
-            if (heishamonSettings->waitTime < 5) heishamonSettings->waitTime = 5;
+            if (heishamonSettings->waitTime < 1) heishamonSettings->waitTime = 1;
             if ( jsonDoc["waitDallasTime"]) heishamonSettings->waitDallasTime = jsonDoc["waitDallasTime"];
             if (heishamonSettings->waitDallasTime < 5) heishamonSettings->waitDallasTime = 5;
             if ( jsonDoc["updateAllTime"]) heishamonSettings->updateAllTime = jsonDoc["updateAllTime"];
@@ -237,7 +242,7 @@ void setupWifi(DoubleResetDetect &drd, settingsStruct *heishamonSettings) {
   Serial.println(WiFi.localIP());
 }
 
-void handleRoot(ESP8266WebServer *httpServer, float readpercentage, settingsStruct *heishamonSettings) {
+void handleRoot(ESP8266WebServer *httpServer, float readpercentage, unsigned long skippedreads, settingsStruct *heishamonSettings, loopProfileStruct *loopProfile) {
   httpServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
   httpServer->send(200, "text/html", "");
   httpServer->sendContent_P(webHeader);
@@ -256,108 +261,205 @@ void handleRoot(ESP8266WebServer *httpServer, float readpercentage, settingsStru
   httpServer->sendContent(String(getFreeMemory()));
   httpServer->sendContent_P(webBodyRootStatusReceived);
   httpServer->sendContent(String(readpercentage));
+  httpServer->sendContent_P(webBodyRootStatusSkipped);
+  httpServer->sendContent(String(skippedreads));
   httpServer->sendContent_P(webBodyRootStatusUptime);
-  httpServer->sendContent(getUptime());
+  httpServer->sendContent(heapTrackString(HEAP_SITE_WEB, getUptime()));
+  httpServer->sendContent_P(webBodyRootStatusHeap);
+  httpServer->sendContent(String(ESP.getFreeHeap()));
+  httpServer->sendContent_P(webBodyRootStatusTopicTable);
+  httpServer->sendContent(String(getTopicTableSize()));
+  httpServer->sendContent_P(webBodyRootStatusTopicTableEnd);
+  httpServer->sendContent_P(webBodyRootStatusLoops);
+  httpServer->sendContent(String(loopProfile->loopsPerSecond));
+  httpServer->sendContent_P(webBodyRootStatusLoopStages);
+  for (byte stage = 0 ; stage < NUMBER_OF_LOOP_STAGES ; stage++) {
+    char stageText[48];
+    unsigned long average = (loopProfile->lastLoops > 0) ? loopProfile->lastStages[stage].time / loopProfile->lastLoops : 0;
+    snprintf(stageText, sizeof(stageText), "%s%s %lu/%lu", (stage > 0) ? ", " : "", getLoopStageName(stage), average, loopProfile->lastStages[stage].max);
+    httpServer->sendContent(stageText);
+  }
   httpServer->sendContent_P(webBodyEndDiv);
 
   httpServer->sendContent_P(webBodyRootHeatpumpValues);
   if (heishamonSettings->use_1wire)httpServer->sendContent_P(webBodyRootDallasValues);
   if (heishamonSettings->use_s0)  httpServer->sendContent_P(webBodyRootS0Values);
  
-  httpServer->sendContent_P(menuJS);
   httpServer->sendContent_P(refreshJS);
-  httpServer->sendContent_P(selectJS);
   httpServer->sendContent_P(webFooter);
   httpServer->sendContent("");
   httpServer->client().stop();
 }
 
-void handleTableRefresh(ESP8266WebServer *httpServer, String actData[]) {
+// Let the browser keep the response for a year when the v argument of the url is the version of the content,
+// as in the links of the pages. Without it the browser has to revalidate, with the version as ETag, so it does
+// not keep an old one after a firmware update. Returns true when answered with 304 Not Modified.
+static bool cacheVersion(ESP8266WebServer *httpServer, const char *version) {
+  if (httpServer->arg("v") == version) {
+    httpServer->sendHeader("Cache-Control", "max-age=31536000, immutable");
+    return false;
+  }
+  char etag[48];
+  snprintf(etag, sizeof(etag), "\"%s\"", version);
+  httpServer->sendHeader("Cache-Control", "no-cache");
+  httpServer->sendHeader("ETag", etag);
+  if (httpServer->header("If-None-Match") != etag) return false;
+  httpServer->send(304, "text/plain", "");
+  return true;
+}
+
+// Serve a gzipped file of webstatic.h straight from flash
+void handleStatic(ESP8266WebServer *httpServer) {
+  for (byte file = 0 ; file < NUMBER_OF_WEB_STATIC ; file++) {
+    if (httpServer->uri() == webStatic[file].path) {
+      if (cacheVersion(httpServer, webStatic[file].version)) return;
+      httpServer->sendHeader("Content-Encoding", "gzip");
+      httpServer->send_P(200, webStatic[file].contentType, (PGM_P)webStatic[file].data, webStatic[file].length);
+      return;
+    }
+  }
+  httpServer->send(404, "text/plain", "Not found");
+}
+
+// Send the ETag of the data version, and answer with 304 Not Modified when the browser has this version already
+static bool notModified(ESP8266WebServer *httpServer, byte source, unsigned long version) {
+  static uint32_t bootId = 0; //the versions start again after a reboot, so they are different for each boot
+  if (bootId == 0) bootId = ESP.random() | 1;
+  char etag[32];
+  snprintf(etag, sizeof(etag), "\"%08x-%u-%lu\"", (unsigned int)bootId, source, version);
+  httpServer->sendHeader("Cache-Control", "no-cache");
+  httpServer->sendHeader("ETag", etag);
+  if (httpServer->header("If-None-Match") != etag) return false;
+  httpServer->send(304, "text/plain", "");
+  return true;
+}
+
+void handleTableRefresh(ESP8266WebServer *httpServer, int32_t actData[]) {
+  byte source = DATA_HEATPUMP;
+  if (httpServer->hasArg("1wire")) source = DATA_DALLAS;
+  else if (httpServer->hasArg("s0")) source = DATA_S0;
+  if (notModified(httpServer, source, getDataVersion(source))) return;
   httpServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
   httpServer->send(200, "text/html", "");
-  if (httpServer->hasArg("1wire")) {
-    httpServer->sendContent(dallasTableOutput());
-  } else if (httpServer->hasArg("s0")) {
-    httpServer->sendContent(s0TableOutput());
+  if (source == DATA_DALLAS) {
+    httpServer->sendContent(heapTrackString(HEAP_SITE_DALLAS, dallasTableOutput()));
+  } else if (source == DATA_S0) {
+    httpServer->sendContent(heapTrackString(HEAP_SITE_S0, s0TableOutput()));
   } else {
+    char valueText[TOPIC_VALUE_TEXT_SIZE];
+    char topicName[TOPIC_NAME_SIZE];
+    char topicDesc[TOPIC_DESCRIPTION_TEXT_SIZE];
     for (unsigned int topic = 0 ; topic < NUMBER_OF_TOPICS ; topic++) {
-      String topicdesc;
-      const char *valuetext = "value";
-      if (strcmp(topicDescription[topic][0], valuetext) == 0) {
-        topicdesc = topicDescription[topic][1];
-      }
-      else {
-        int value = actData[topic].toInt();
-        int maxvalue = atoi(topicDescription[topic][0]);
-        if ((value < 0) || (value > maxvalue)) {
-          topicdesc = "unknown";
-        }
-        else {
-          topicdesc = topicDescription[topic][value + 1]; //plus one, because 0 is the maxvalue container
-        }
-      }
-      String tabletext = "<tr>";
-      tabletext = tabletext + "<td>TOP" + topic + "</td>";
-      tabletext = tabletext + "<td>" + topics[topic] + "</td>";
-      tabletext = tabletext + "<td>" + actData[topic] + "</td>";
-      tabletext = tabletext + "<td>" + topicdesc + "</td>";
+      String tabletext = "<tr id=\"TOP";
+      tabletext = tabletext + topic + "\"><td>TOP" + topic + "</td>";
+      tabletext = tabletext + "<td>" + getTopicName(topic, topicName) + "</td>";
+      tabletext = tabletext + "<td>" + formatTopicValue(topic, actData[topic], valueText) + "</td>";
+      tabletext = tabletext + "<td>" + getTopicDescription(topic, actData[topic], topicDesc) + "</td>";
       tabletext = tabletext + "</tr>";
-      httpServer->sendContent(tabletext);
+      httpServer->sendContent(heapTrackString(HEAP_SITE_WEB, tabletext));
     }
   }
   httpServer->sendContent("");
   httpServer->client().stop();
 }
 
-void handleJsonOutput(ESP8266WebServer *httpServer, String actData[]) {
-  httpServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+void handleJsonOutput(ESP8266WebServer *httpServer, int32_t actData[]) {
+  jsonWriterStruct json;
+  char valueText[TOPIC_VALUE_TEXT_SIZE];
+  char topicName[TOPIC_NAME_SIZE];
+  char topicDesc[TOPIC_DESCRIPTION_TEXT_SIZE];
+  char topicText[16] = "TOP";
   httpServer->sendHeader("Access-Control-Allow-Origin", "*");
-  httpServer->send(200, "application/json", "");
-  //begin json
-  String tabletext = "{";
+  if (notModified(httpServer, NUMBER_OF_DATA_SOURCES, getDataVersion())) return; //all sources
+  jsonBegin(&json, httpServer);
   //heatpump values in json
-  tabletext = tabletext + "\"heatpump\":[";
-  httpServer->sendContent(tabletext);
+  jsonArrayBegin(&json, PSTR("heatpump"));
   for (unsigned int topic = 0 ; topic < NUMBER_OF_TOPICS ; topic++) {
-    String topicdesc;
-    const char *valuetext = "value";
-    if (strcmp(topicDescription[topic][0], valuetext) == 0) {
-      topicdesc = topicDescription[topic][1];
-    }
-    else {
-      int value = actData[topic].toInt();
-      int maxvalue = atoi(topicDescription[topic][0]);
-      if ((value < 0) || (value > maxvalue)) {
-        topicdesc = "unknown";
-      }
-      else {
-        topicdesc = topicDescription[topic][value + 1]; //plus one, because 0 is the maxvalue container
-      }
-    }
-    tabletext = "{";
-    tabletext = tabletext + "\"Topic\": \"TOP" + topic + "\",";
-    tabletext = tabletext + "\"Name\": \"" + topics[topic] + "\",";
-    tabletext = tabletext + "\"Value\": \"" + actData[topic] + "\",";
-    tabletext = tabletext + "\"Description\": \"" + topicdesc + "\"";
-    tabletext = tabletext + "}";
-    if (topic < NUMBER_OF_TOPICS - 1) tabletext = tabletext + ",";
-    httpServer->sendContent(tabletext);
+    formatUnsigned(topic, &topicText[3]);
+    jsonObjectBegin(&json, 0);
+    jsonString(&json, PSTR("Topic"), topicText);
+    jsonString(&json, PSTR("Name"), getTopicName(topic, topicName));
+    jsonString(&json, PSTR("Value"), formatTopicValue(topic, actData[topic], valueText));
+    jsonString(&json, PSTR("Description"), getTopicDescription(topic, actData[topic], topicDesc));
+    jsonObjectEnd(&json);
   }
-  tabletext = "]";
-  httpServer->sendContent(tabletext);
+  jsonArrayEnd(&json);
   //1wire data in json
-  tabletext =  ",\"1wire\":" + dallasJsonOutput();
-  httpServer->sendContent(tabletext);
+  jsonArrayBegin(&json, PSTR("1wire"));
+  dallasJsonOutput(&json);
+  jsonArrayEnd(&json);
   //s0 data in json
-  tabletext =  ",\"s0\":" + s0JsonOutput();
-  httpServer->sendContent(tabletext);
-  //end json string
-  tabletext = "}";
-  httpServer->sendContent(tabletext);
+  jsonArrayBegin(&json, PSTR("s0"));
+  s0JsonOutput(&json);
+  jsonArrayEnd(&json);
+  jsonEnd(&json);
+}
+
+// The topic names, units and enum labels of /values. They only change with the firmware, which is in
+// the url a client gets from the Link header of /values, so with that url the browser may keep them.
+void handleMeta(ESP8266WebServer *httpServer) {
+  jsonWriterStruct json;
+  httpServer->sendHeader("Access-Control-Allow-Origin", "*");
+  if (cacheVersion(httpServer, heishamon_version)) return;
+  jsonBegin(&json, httpServer);
+  jsonString(&json, PSTR("Version"), heishamon_version);
+  jsonArrayBegin(&json, PSTR("heatpump"));
+  topicMetaJsonOutput(&json);
+  jsonArrayEnd(&json);
+  jsonEnd(&json);
+}
+
+// Only the heatpump values, positional in the topic order of /meta
+void handleValues(ESP8266WebServer *httpServer, int32_t actData[]) {
+  jsonWriterStruct json;
+  char metaLink[64];
+  snprintf(metaLink, sizeof(metaLink), "</meta?v=%s>; rel=\"describedby\"", heishamon_version);
+  httpServer->sendHeader("Access-Control-Allow-Origin", "*");
+  httpServer->sendHeader("Link", metaLink);
+  if (notModified(httpServer, DATA_HEATPUMP, getDataVersion(DATA_HEATPUMP))) return;
+  jsonBegin(&json, httpServer);
+  jsonArrayBegin(&json, PSTR("heatpump"));
+  topicValuesJsonOutput(&json, actData);
+  jsonArrayEnd(&json);
+  jsonEnd(&json);
+}
+
+// The log messages still in the ring, oldest first, with ?level=n only the messages of that level and more severe
+void handleLog(ESP8266WebServer *httpServer, logRingStruct *logRing) {
+  byte level = LOG_DEBUG;
+  if (httpServer->hasArg("level")) level = httpServer->arg("level").toInt();
+  httpServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  httpServer->send(200, "text/plain", "");
+  logEntryStruct entry;
+  char prefix[32]; // the text is sent from the entry itself, the newline ending the previous line goes in front
+  bool first = true;
+  unsigned int position = logRing->tail;
+  for (unsigned int i = 0 ; i < logRing->count ; i++) {
+    position = logRingRead(logRing, position, &entry);
+    if (entry.level > level) continue;
+    snprintf(prefix, sizeof(prefix), "%s%lu %s ", first ? "" : "\n", entry.time, getLogLevelName(entry.level));
+    httpServer->sendContent(prefix);
+    httpServer->sendContent(entry.text);
+    first = false;
+  }
+  if (!first) httpServer->sendContent("\n");
   httpServer->sendContent("");
   httpServer->client().stop();
 }
 
+void handleHeapStats(ESP8266WebServer *httpServer) {
+  char json[HEAPSTATSJSONSIZE];
+  heapStatsJson(json, sizeof(json));
+  httpServer->sendHeader("Access-Control-Allow-Origin", "*");
+  httpServer->send(200, "application/json", json);
+}
+
+void handleSerialStats(ESP8266WebServer *httpServer, serialStatsStruct *serialStats) {
+  char json[SERIALSTATSJSONSIZE];
+  serialStatsJson(serialStats, json, sizeof(json));
+  httpServer->sendHeader("Access-Control-Allow-Origin", "*");
+  httpServer->send(200, "application/json", json);
+}
 
 void handleFactoryReset(ESP8266WebServer *httpServer) {
   httpServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
@@ -366,7 +468,6 @@ void handleFactoryReset(ESP8266WebServer *httpServer) {
   httpServer->sendContent_P(refreshMeta);
   httpServer->sendContent_P(webBodyStart);
   httpServer->sendContent_P(webBodyFactoryResetWarning);
-  httpServer->sendContent_P(menuJS);
   httpServer->sendContent_P(webFooter);
   httpServer->sendContent("");
   httpServer->client().stop();
@@ -385,7 +486,6 @@ void handleReboot(ESP8266WebServer *httpServer) {
   httpServer->sendContent_P(refreshMeta);
   httpServer->sendContent_P(webBodyStart);
   httpServer->sendContent_P(webBodyRebootWarning);
-  httpServer->sendContent_P(menuJS);
   httpServer->sendContent_P(webFooter);
   httpServer->sendContent("");
   httpServer->client().stop();
@@ -403,7 +503,7 @@ void handleSettings(ESP8266WebServer *httpServer, settingsStruct *heishamonSetti
 
   //check if POST was made with save settings, if yes then save and reboot
   if (httpServer->args()) {
-    DynamicJsonDocument jsonDoc(1024);
+    DynamicJsonDocument jsonDoc(2048); //the posted strings are copied into the document, topicFilters alone can be 256 bytes
     //set jsonDoc with current settings
     jsonDoc["wifi_hostname"] = heishamonSettings->wifi_hostname;
     jsonDoc["ota_password"] = heishamonSettings->ota_password;
@@ -447,6 +547,13 @@ void handleSettings(ESP8266WebServer *httpServer, settingsStruct *heishamonSetti
     } else {
       jsonDoc["optionalPCB"] = "disabled";
     }    
+    if (heishamonSettings->mqttPublishTopics) {
+      jsonDoc["mqttPublishTopics"] = "enabled";
+    } else {
+      jsonDoc["mqttPublishTopics"] = "disabled";
+    }
+    jsonDoc["mqttPublishJson"] = heishamonSettings->mqttPublishJson;
+    jsonDoc["topicFilters"] = heishamonSettings->topicFilters;
     jsonDoc["waitTime"] = heishamonSettings->waitTime;
     jsonDoc["waitDallasTime"] = heishamonSettings->waitDallasTime;
     jsonDoc["updateAllTime"] = heishamonSettings->updateAllTime;
@@ -526,6 +633,17 @@ void handleSettings(ESP8266WebServer *httpServer, settingsStruct *heishamonSetti
     } else {
       jsonDoc["optionalPCB"] = "disabled";
     }    
+    if (httpServer->hasArg("mqttPublishTopics")) {
+      jsonDoc["mqttPublishTopics"] = "enabled";
+    } else {
+      jsonDoc["mqttPublishTopics"] = "disabled";
+    }
+    if (httpServer->hasArg("mqttPublishJson")) {
+      jsonDoc["mqttPublishJson"] = httpServer->arg("mqttPublishJson");
+    }
+    if (httpServer->hasArg("topicFilters")) {
+      jsonDoc["topicFilters"] = httpServer->arg("topicFilters");
+    }
     if (httpServer->hasArg("waitTime")) {
       jsonDoc["waitTime"] = httpServer->arg("waitTime");
     }
@@ -587,11 +705,28 @@ void handleSettings(ESP8266WebServer *httpServer, settingsStruct *heishamonSetti
   httptext = httptext + "<input type=\"password\" name=\"mqtt_password\" value=\"" + heishamonSettings->mqtt_password + "\">";
   httptext = httptext + "</td></tr><tr><td style=\"text-align:right; width: 50%\">";
   httptext = httptext + "How often new values are collected from heatpump:</td><td style=\"text-align:left\">";
-  httptext = httptext + "<input type=\"number\" name=\"waitTime\" value=\"" + heishamonSettings->waitTime + "\"> seconds  (min 5 sec)";
+  httptext = httptext + "<input type=\"number\" name=\"waitTime\" value=\"" + heishamonSettings->waitTime + "\"> seconds  (min 1 sec)";
   httptext = httptext + "</td></tr><tr><td style=\"text-align:right; width: 50%\">";
   httptext = httptext + "How often all heatpump values are retransmitted to MQTT broker:</td><td style=\"text-align:left\">";
   httptext = httptext + "<input type=\"number\" name=\"updateAllTime\" value=\"" + heishamonSettings->updateAllTime + "\"> seconds";
   httptext = httptext + "</td></tr><tr><td style=\"text-align:right; width: 50%\">";
+  httptext = httptext + "Publish each heatpump value to its own MQTT topic:</td><td style=\"text-align:left\">";
+  if (heishamonSettings->mqttPublishTopics) {
+    httptext = httptext + "<input type=\"checkbox\" name=\"mqttPublishTopics\" value=\"enabled\" checked >";
+  } else {
+    httptext = httptext + "<input type=\"checkbox\" name=\"mqttPublishTopics\" value=\"enabled\">";
+  }
+  httptext = httptext + "</td></tr><tr><td style=\"text-align:right; width: 50%\">";
+  httptext = httptext + "Publish heatpump values as one JSON message:</td><td style=\"text-align:left\">";
+  httptext = httptext + "<select name=\"mqttPublishJson\">";
+  httptext = httptext + "<option value=\"0\"" + (heishamonSettings->mqttPublishJson == MQTT_JSON_OFF ? " selected" : "") + ">Off</option>";
+  httptext = httptext + "<option value=\"1\"" + (heishamonSettings->mqttPublishJson == MQTT_JSON_ALL ? " selected" : "") + ">All values</option>";
+  httptext = httptext + "<option value=\"2\"" + (heishamonSettings->mqttPublishJson == MQTT_JSON_CHANGED ? " selected" : "") + ">Only changed values</option>";
+  httptext = httptext + "</select>";
+  httptext = httptext + "</td></tr><tr><td style=\"text-align:right; width: 50%\">";
+  httptext = httptext + "Only publish changes larger than a deadband, and not more often than an interval (Name:deadband:percent:seconds, comma separated, for example Pump_Flow:0.1:0:60):</td><td style=\"text-align:left\">";
+  httptext = httptext + "<input type=\"text\" name=\"topicFilters\" maxlength=\"" + (TOPIC_FILTERS_SIZE - 1) + "\" value=\"" + heishamonSettings->topicFilters + "\">";
+  httptext = httptext + "</td></tr><tr><td style=\"text-align:right; width: 50%\">";
   httptext = httptext + "Listen only mode:</td><td style=\"text-align:left\">";
   if (heishamonSettings->listenonly) {
     httptext = httptext + "<input type=\"checkbox\" name=\"listenonly\" value=\"enabled\" checked >";
@@ -696,19 +831,15 @@ void handleSettings(ESP8266WebServer *httpServer, settingsStruct *heishamonSetti
   httptext = httptext + "</div>";
   httpServer->sendContent(httptext);
 
-  httpServer->sendContent_P(menuJS);
-  httpServer->sendContent_P(settingsJS);
   httpServer->sendContent_P(webFooter);
   httpServer->sendContent("");
   httpServer->client().stop();
 }
 
-bool send_command(byte* command, int length);
+bool send_command(byte* command, int length, byte key);
 void log_message(char* string);
 
 void handleREST(ESP8266WebServer *httpServer) {
-  int arraysize = sizeof(commands)/sizeof(commands[0]);
-
   httpServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
   httpServer->sendHeader("Access-Control-Allow-Origin", "*");
   httpServer->send(200, "text/plain", "");
@@ -716,19 +847,14 @@ void handleREST(ESP8266WebServer *httpServer) {
   String httptext = "";
   if(httpServer->method() == HTTP_GET) {
     for(uint8_t i = 0; i < httpServer->args(); i++) {
-      unsigned char cmd[256] = { 0 }, *p = cmd;
-      char log_msg[256] = { 0 }, *l = log_msg;
-      unsigned int len = 0;
-
-      int x = 0;
-
-      for(x=0;x<arraysize;x++) {
-        if(strcmp(httpServer->argName(i).c_str(), commands[x].name) == 0) {
-          len = commands[x].func((char *)httpServer->arg(i).c_str(), &p, &l);
-          httptext = httptext + log_msg + "\n";
-          log_message(log_msg);
-          send_command(cmd, len);
-        }
+      int command = findCommand(httpServer->argName(i).c_str());
+      if (command >= 0) {
+        byte cmd[SETCOMMANDSIZE];
+        char log_msg[COMMAND_LOG_SIZE];
+        unsigned int len = encodeCommand(command, (char *)httpServer->arg(i).c_str(), cmd, log_msg);
+        httptext = httptext + log_msg + "\n";
+        log_message(log_msg);
+        if (len > 0) send_command(cmd, len, command);
       }
     }
   }
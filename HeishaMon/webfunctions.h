@@ -5,6 +5,13 @@
 #include <ArduinoJson.h>
 #include "dallas.h"
 #include "s0.h"
+#include "serialstats.h"
+#include "loopprofile.h"
+#include "heapstats.h"
+#include "logring.h"
+#include "dataversion.h"
+
+#define TOPIC_FILTERS_SIZE 256 // size of the topic filter setting: Name:deadband:percent:interval,Name:...
 
 struct settingsStruct {
   unsigned int waitTime = 5; // how often data is read from heatpump
@@ -29,6 +36,9 @@ struct settingsStruct {
   bool logMqtt = false; //log to mqtt from start
   bool logHexdump = false; //log hexdump from start
   bool logSerial1 = true; //log to serial1 (gpio2) from start  
+  bool mqttPublishTopics = true; //publish each heatpump value to its own mqtt topic
+  char topicFilters[TOPIC_FILTERS_SIZE] = ""; //publish filters (deadband and minimum interval) of noisy topics
+  byte mqttPublishJson = 0; //also publish all heatpump values as one json message, 0 = off, 1 = all values, 2 = only changed values
 
   s0SettingsStruct s0Settings[NUM_S0_COUNTERS];
 };
@@ -38,9 +48,15 @@ String getUptime(void);
 void setupWifi(DoubleResetDetect &drd, settingsStruct *heishamonSettings);
 int getWifiQuality(void);
 int getFreeMemory(void);
-void handleRoot(ESP8266WebServer *httpServer, float readpercentage, settingsStruct *heishamonSettings);
-void handleTableRefresh(ESP8266WebServer *httpServer, String actData[]);
-void handleJsonOutput(ESP8266WebServer *httpServer, String actData[]);
+void handleRoot(ESP8266WebServer *httpServer, float readpercentage, unsigned long skippedreads, settingsStruct *heishamonSettings, loopProfileStruct *loopProfile);
+void handleStatic(ESP8266WebServer *httpServer);
+void handleTableRefresh(ESP8266WebServer *httpServer, int32_t actData[]);
+void handleJsonOutput(ESP8266WebServer *httpServer, int32_t actData[]);
+void handleMeta(ESP8266WebServer *httpServer);
+void handleValues(ESP8266WebServer *httpServer, int32_t actData[]);
+void handleHeapStats(ESP8266WebServer *httpServer);
+void handleLog(ESP8266WebServer *httpServer, logRingStruct *logRing);
+void handleSerialStats(ESP8266WebServer *httpServer, serialStatsStruct *serialStats);
 void handleFactoryReset(ESP8266WebServer *httpServer);
 void handleReboot(ESP8266WebServer *httpServer);
 void handleSettings(ESP8266WebServer *httpServer, settingsStruct *heishamonSettings);
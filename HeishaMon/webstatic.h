@@ -0,0 +1,82 @@
+// Generated by Tools/webstatic/gzipstatic.py from Tools/webstatic, do not edit
+#ifndef WEBSTATIC_H
+#define WEBSTATIC_H
+
+#define WEBSTATIC_JS_URL "/heishamon.js?v=3f881f32"
+// heishamon.js: 2427 bytes, 929 bytes gzipped
+static const uint8_t webStaticHeishamonJs[] PROGMEM = {
+  0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x8d, 0x56, 0x6d, 0x6f, 0xdb, 0x38,
+  0x0c, 0xfe, 0x9e, 0x5f, 0xc1, 0xcb, 0x06, 0xd8, 0xb9, 0x16, 0xb6, 0xbb, 0x02, 0xc3, 0xa1, 0x5e,
+  0x30, 0x60, 0xbb, 0xe1, 0x7a, 0x87, 0x65, 0x1b, 0x90, 0x02, 0xfb, 0x50, 0x04, 0x83, 0x6a, 0xd3,
+  0xb1, 0x36, 0x47, 0xf2, 0x49, 0x72, 0xdd, 0xdc, 0x90, 0xff, 0x7e, 0x94, 0x64, 0xc7, 0x79, 0x59,
+  0xb2, 0xf5, 0x43, 0x9a, 0xd0, 0x0f, 0xc9, 0x87, 0x0f, 0x29, 0xca, 0x71, 0x0c, 0xf3, 0x4c, 0xf1,
+  0xda, 0x68, 0x90, 0x05, 0x98, 0x12, 0xe1, 0x16, 0xb9, 0x2e, 0xd9, 0x4c, 0x0a, 0x68, 0xf1, 0x01,
+  0x6a, 0xb6, 0x44, 0x1d, 0xc1, 0x5f, 0xff, 0xf1, 0x9a, 0x9e, 0x72, 0x0d, 0x5c, 0x18, 0x39, 0x60,
+  0x62, 0xc2, 0x68, 0xc3, 0x0c, 0xcf, 0xa2, 0x12, 0x5a, 0x6e, 0x4a, 0x58, 0x12, 0xb2, 0xb3, 0xd4,
+  0x6b, 0x60, 0x85, 0x41, 0x05, 0x0c, 0xb2, 0x92, 0x89, 0x25, 0x46, 0xa3, 0x51, 0xd1, 0x88, 0xcc,
+  0x70, 0x0a, 0x2e, 0x6b, 0x14, 0xef, 0xb1, 0x30, 0x33, 0x14, 0x4d, 0x38, 0x81, 0xef, 0x23, 0x80,
+  0x47, 0xa6, 0xe0, 0x09, 0xa6, 0x90, 0xcb, 0xac, 0x59, 0xa1, 0x30, 0xd1, 0x12, 0xcd, 0xbb, 0x0a,
+  0xed, 0xd7, 0x37, 0xeb, 0xbf, 0xf3, 0x70, 0x5c, 0x75, 0xf8, 0xf1, 0x24, 0x25, 0x38, 0x2f, 0x20,
+  0x7c, 0x8a, 0xb4, 0x59, 0x57, 0x18, 0xe5, 0x5c, 0xd7, 0x15, 0x5b, 0xc3, 0x74, 0x3a, 0x85, 0xb1,
+  0x90, 0x02, 0xc7, 0x3e, 0x24, 0xc0, 0x11, 0x02, 0xc6, 0x0f, 0x95, 0xcc, 0xbe, 0x8d, 0x6d, 0x88,
+  0x0d, 0x60, 0xa5, 0xf1, 0x34, 0xd2, 0x45, 0x72, 0xc0, 0xd1, 0x66, 0x34, 0x8a, 0x63, 0x50, 0x52,
+  0x1a, 0xa7, 0xc9, 0x8d, 0xd3, 0xea, 0x91, 0x55, 0x0d, 0x82, 0x61, 0x0f, 0x15, 0xea, 0x91, 0xa5,
+  0x5f, 0xf1, 0x47, 0x24, 0xc7, 0x82, 0x51, 0xd8, 0x4b, 0x30, 0x7c, 0x45, 0xd5, 0x4f, 0x21, 0x49,
+  0x87, 0xba, 0x15, 0x16, 0x0a, 0x75, 0x79, 0x67, 0x7d, 0xba, 0xba, 0xb3, 0x0a, 0x99, 0xba, 0x23,
+  0xac, 0x6c, 0x4c, 0xe8, 0x7c, 0x5c, 0x7d, 0xcf, 0xc3, 0xe0, 0x59, 0xe9, 0x84, 0x76, 0x69, 0x74,
+  0x30, 0x89, 0x2a, 0xc9, 0xf2, 0x30, 0x88, 0x5d, 0xc2, 0x2e, 0x50, 0x70, 0x09, 0x7d, 0x6c, 0x1b,
+  0xce, 0x8a, 0xf2, 0x9b, 0x65, 0x31, 0xd9, 0x66, 0xd7, 0x68, 0xfa, 0xe0, 0xbb, 0xc9, 0x2f, 0xe1,
+  0x3a, 0xa1, 0xbf, 0x49, 0xba, 0xd9, 0x66, 0xcb, 0x59, 0x55, 0x31, 0x7d, 0x2e, 0xdb, 0xeb, 0xab,
+  0x96, 0x2b, 0x3c, 0xc8, 0x39, 0x04, 0xd0, 0xc9, 0x59, 0x67, 0x9d, 0xfc, 0xc0, 0x73, 0xb3, 0x3f,
+  0x13, 0x73, 0xea, 0x0d, 0x9a, 0x4e, 0x19, 0x57, 0x4d, 0xcb, 0x45, 0x2e, 0xdb, 0xe8, 0x33, 0x3e,
+  0xf8, 0x67, 0x13, 0xd2, 0xd0, 0x34, 0x4a, 0xa4, 0xdd, 0xc8, 0x68, 0x67, 0xa5, 0x42, 0x05, 0xb6,
+  0xb0, 0x45, 0x85, 0x41, 0xab, 0x6f, 0xe2, 0x38, 0x80, 0x0b, 0xa0, 0x76, 0x33, 0x1b, 0x3f, 0x2a,
+  0xa5, 0x36, 0x82, 0xad, 0x90, 0x6c, 0xc1, 0xcd, 0x1f, 0x57, 0x71, 0xe0, 0x88, 0x7b, 0xff, 0x48,
+  0x0a, 0x9b, 0xde, 0x36, 0x6f, 0x87, 0x60, 0xd7, 0x4f, 0xa3, 0x1a, 0x4c, 0x0f, 0x5a, 0x97, 0x6e,
+  0xf6, 0x9c, 0xb3, 0x4a, 0x6a, 0x3c, 0xf0, 0xb6, 0xf4, 0x7d, 0x2f, 0xbe, 0xef, 0x0e, 0xc6, 0x71,
+  0xa4, 0xdd, 0x1e, 0x0d, 0x22, 0x0c, 0x1d, 0xda, 0xcb, 0xb4, 0x42, 0xad, 0x69, 0x02, 0x77, 0x73,
+  0xe1, 0x23, 0x9d, 0x91, 0x7e, 0xe2, 0xad, 0x26, 0xbe, 0x0d, 0x04, 0xf9, 0x67, 0xfe, 0xf1, 0x43,
+  0x54, 0x33, 0xa5, 0xd1, 0x83, 0xa2, 0x9c, 0x19, 0xe6, 0xca, 0xf6, 0xea, 0x7a, 0x60, 0xa4, 0xd0,
+  0xf6, 0x8b, 0x22, 0x3c, 0xdf, 0xb7, 0xd0, 0x81, 0x82, 0xc0, 0xf7, 0x1c, 0x5e, 0xc3, 0xc1, 0x84,
+  0xc0, 0x0d, 0xfc, 0xb4, 0xe5, 0x56, 0xff, 0xfd, 0x1c, 0x69, 0xdf, 0xbe, 0x8d, 0x23, 0x51, 0x48,
+  0x65, 0x59, 0x28, 0xe0, 0xee, 0xa0, 0xd0, 0xbf, 0x57, 0xbd, 0x43, 0x85, 0x62, 0x69, 0x4a, 0x32,
+  0x5d, 0x5c, 0xf4, 0xb5, 0xf9, 0xea, 0x94, 0x6c, 0xcf, 0xac, 0x89, 0xe0, 0xee, 0xe3, 0xa7, 0x21,
+  0xed, 0x3d, 0x5f, 0xdc, 0x27, 0x8b, 0xae, 0x62, 0x5f, 0x33, 0xb9, 0x53, 0x3c, 0xfa, 0x8c, 0x32,
+  0xac, 0x2a, 0x7d, 0xff, 0x62, 0x11, 0x71, 0x21, 0x50, 0xdd, 0xde, 0xcd, 0xde, 0x53, 0xdc, 0xc1,
+  0xef, 0x6a, 0x91, 0xc2, 0x00, 0xbb, 0x3e, 0x05, 0x7b, 0xb1, 0xe8, 0x6a, 0xb1, 0x9f, 0x9b, 0xa3,
+  0x89, 0xf6, 0x5d, 0x76, 0xaa, 0x7c, 0xa0, 0xe1, 0x1b, 0x76, 0x1d, 0x4f, 0xcf, 0x2f, 0x3d, 0xfd,
+  0x66, 0xfd, 0x96, 0xd4, 0xd6, 0xd6, 0x2b, 0x1c, 0xfb, 0x55, 0xe0, 0xc2, 0xf8, 0xfd, 0xe7, 0x94,
+  0xdb, 0x51, 0xed, 0xe9, 0x47, 0x82, 0x3d, 0x11, 0xc1, 0xb3, 0x7b, 0x0d, 0x4e, 0xea, 0x38, 0x30,
+  0x3e, 0xbd, 0x42, 0xfd, 0x56, 0xa4, 0xe9, 0x35, 0x5c, 0x2c, 0xb5, 0xdb, 0x8c, 0x43, 0xf1, 0xf3,
+  0x52, 0xb6, 0xb7, 0x3c, 0xc7, 0x3f, 0xdd, 0xd0, 0x78, 0x19, 0xfc, 0x00, 0xbd, 0x13, 0xf6, 0x47,
+  0x3e, 0x48, 0xe1, 0xcd, 0xdb, 0x38, 0x67, 0xee, 0x80, 0x7d, 0xa4, 0x57, 0x62, 0xdf, 0x76, 0xc4,
+  0x76, 0x2f, 0x67, 0x94, 0x95, 0x48, 0x07, 0x29, 0xa7, 0x71, 0x1e, 0x7b, 0x31, 0x69, 0x8c, 0x7b,
+  0x41, 0x36, 0xc7, 0xe4, 0xe7, 0x89, 0x27, 0xae, 0x13, 0x3c, 0x24, 0xad, 0x93, 0x5f, 0x21, 0x3c,
+  0xa0, 0x3c, 0xd9, 0xe1, 0xf7, 0x11, 0xd1, 0x6d, 0x8e, 0x5f, 0x25, 0xe9, 0xaf, 0xd5, 0x19, 0x17,
+  0x9f, 0x99, 0x31, 0x61, 0x2d, 0x95, 0x19, 0xd8, 0xd5, 0xf5, 0xb7, 0xb6, 0x3c, 0x77, 0x4c, 0x74,
+  0xf2, 0xc5, 0x61, 0xbe, 0x04, 0x17, 0xce, 0x33, 0x72, 0x13, 0xdd, 0xcf, 0x24, 0xdd, 0xf3, 0xa8,
+  0xc8, 0xf2, 0x93, 0x08, 0x3d, 0xec, 0x38, 0xc8, 0x39, 0xaf, 0x15, 0x17, 0x2d, 0x31, 0xde, 0x3a,
+  0xed, 0x9e, 0xab, 0x19, 0x33, 0x65, 0xa4, 0x64, 0x23, 0xf2, 0x30, 0xbc, 0x7e, 0x99, 0x24, 0xf0,
+  0x3b, 0x5c, 0xd1, 0x16, 0x84, 0xd8, 0x57, 0x34, 0xa1, 0x2f, 0x7d, 0xd2, 0x49, 0x3f, 0x80, 0xf6,
+  0x2e, 0xd6, 0xee, 0x35, 0x06, 0xe8, 0x15, 0x25, 0xc7, 0x02, 0x95, 0xc2, 0xfc, 0x92, 0x76, 0xa6,
+  0x7b, 0x64, 0xc7, 0xd2, 0x3e, 0x70, 0x7b, 0x30, 0x87, 0x90, 0x89, 0x1c, 0xbe, 0xfe, 0xdb, 0xa0,
+  0x5a, 0x83, 0x5d, 0x49, 0x64, 0x22, 0x2d, 0x2d, 0x70, 0x7b, 0xbd, 0x4f, 0xa0, 0x2d, 0x51, 0xf8,
+  0x37, 0x1e, 0xd5, 0x08, 0x3d, 0xb2, 0x7b, 0xe3, 0x64, 0x45, 0xfb, 0xb7, 0xb4, 0x6f, 0xc1, 0xc1,
+  0x8a, 0x27, 0xcb, 0xee, 0xed, 0x66, 0x89, 0xff, 0x0f, 0x8f, 0x76, 0x88, 0xc9, 0x7b, 0x09, 0x00,
+  0x00,
+};
+
+struct webStaticStruct {
+  const char *path;
+  const char *contentType;
+  const char *version;  // hash of the content, the v argument of the url
+  const uint8_t *data;
+  unsigned int length;
+};
+
+#define NUMBER_OF_WEB_STATIC 1
+static const webStaticStruct webStatic[NUMBER_OF_WEB_STATIC] = {
+  { "/heishamon.js", "application/javascript", "3f881f32", webStaticHeishamonJs, sizeof(webStaticHeishamonJs) },
+};
+
+#endif
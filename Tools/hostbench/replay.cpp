@@ -0,0 +1,978 @@
+/* Host replay benchmark for the HeishaMon decoder
+
+   Replays a corpus of recorded 203 byte heatpump answers through decode_heatpump_data and
+   reports the decode speed, heap allocations and mqtt publishes per frame.
+
+   usage: hostbench golden <frames.txt> [publish] [filters] print every published topic per frame (golden output)
+          hostbench bench <frames.txt> [passes] [publish] [filters] replay the corpus passes times and report the cost
+          hostbench parser <frames.txt> [percent] feed the corpus as one corrupted serial stream through
+                                                 the frame parser and report how many frames are recovered
+          hostbench publish <frames.txt> [passes] time the topic and value formatting of a publish, sprintf
+                                                 against the precomputed topic prefix and integer formatting
+          hostbench commands <frames.txt> [rounds] replay bursts of set commands from an automation through the
+                                                 command buffer and report the bus transactions needed
+          hostbench scheduler <frames.txt> [interval] simulate an hour of panasonic queries every interval millis,
+                                                 optional pcb queries and user commands on the bus and report
+                                                 the bus utilisation and how long commands wait
+          hostbench dispatch <frames.txt> [passes] time finding what to do with a command topic, the old strcmp
+                                                 chain and linear search against the sorted command topics
+          hostbench json <frames.txt>            build the /json response of the last frame, with Strings against
+                                                 the streaming json writer, and report the peak heap and chunks
+
+   publish selects what is published per decode cycle: topics (default), json, delta (json with only the
+   changed values), topics+json or topics+delta. filters is the topic filter setting, for example
+   "Pump_Flow:0.1:0:60,Compressor_Current:0.2"
+*/
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <ESP8266WebServer.h>
+#include <malloc.h>
+#include <time.h>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "decode.h"
+#include "commands.h"
+#include "frameparser.h"
+#include "publish.h"
+#include "commandqueue.h"
+#include "busscheduler.h"
+#include "jsonwriter.h"
+#include "dataversion.h"
+
+// count every heap allocation, the String temporaries on the device all end up here as well
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_realloc(void *ptr, size_t size);
+extern "C" void *__libc_calloc(size_t nmemb, size_t size);
+extern "C" void __libc_free(void *ptr);
+static unsigned long allocations = 0;
+static bool countAllocations = false;
+static long heapInUse = 0; // bytes allocated while counting and not freed yet
+static long heapPeak = 0;
+
+static void *countHeap(void *ptr) {
+  if (countAllocations && ptr) {
+    heapInUse += malloc_usable_size(ptr);
+    if (heapInUse > heapPeak) heapPeak = heapInUse;
+  }
+  return ptr;
+}
+
+extern "C" void *malloc(size_t size) {
+  if (countAllocations) allocations++;
+  return countHeap(__libc_malloc(size));
+}
+
+extern "C" void *realloc(void *ptr, size_t size) {
+  if (countAllocations) {
+    allocations++;
+    if (ptr) heapInUse -= malloc_usable_size(ptr);
+  }
+  return countHeap(__libc_realloc(ptr, size));
+}
+
+extern "C" void *calloc(size_t nmemb, size_t size) {
+  if (countAllocations) allocations++;
+  return countHeap(__libc_calloc(nmemb, size));
+}
+
+extern "C" void free(void *ptr) {
+  if (countAllocations && ptr) heapInUse -= malloc_usable_size(ptr);
+  __libc_free(ptr);
+}
+
+#define FRAMESIZE 203
+#define POLLTIME 5000 // default waitTime of 5 seconds between frames
+
+#define FRAMEPREFIXSIZE 16
+
+struct frameStruct {
+  char data[FRAMESIZE];
+  byte prefix[FRAMEPREFIXSIZE]; // bytes on the line before the answer, for the parser replay
+  unsigned int prefixLength = 0;
+};
+
+static std::vector<frameStruct> frames;
+static PubSubClient mqtt_client;
+static int32_t actData[NUMBER_OF_TOPICS];
+static char mqtt_topic_base[40] = "panasonic_heat_pump";
+static mqttTopicStruct mqttTopicBase;
+static mqttTopicStruct mqttTopicValues;
+static unsigned int updateAllTime = 300;
+static bool mqttPublishTopics = true;
+static byte mqttPublishJson = MQTT_JSON_OFF;
+static const char *topicFilterSetting = "";
+static unsigned long logMessages = 0;
+static unsigned long skippedFrames = 0;
+
+static void log_message(char *string) {
+  logMessages++;
+}
+
+static void printPublish(const char *topic, const char *payload, unsigned int plength, bool retained) {
+  printf("%s %.*s\n", topic, (int)plength, payload);
+}
+
+static bool loadFrames(const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    fprintf(stderr, "can not open %s\n", path);
+    return false;
+  }
+  char line[1024];
+  unsigned int lineno = 0;
+  while (fgets(line, sizeof(line), fp)) {
+    lineno++;
+    if ((line[0] == '#') || (line[0] == '\n') || (line[0] == '\r')) continue;
+    frameStruct frame;
+    char *p = line;
+    char *space = strchr(line, ' ');
+    if (space) { //line noise before the answer
+      for (; (p < space) && (frame.prefixLength < FRAMEPREFIXSIZE); p += 2) {
+        unsigned int value;
+        if (sscanf(p, "%2x", &value) != 1) break;
+        frame.prefix[frame.prefixLength++] = value;
+      }
+      p = space + 1;
+    }
+    unsigned int len = 0;
+    for (; (p[0] != '\0') && (p[1] != '\0') && (len < FRAMESIZE); p += 2) {
+      unsigned int value;
+      if ((p[0] == '\n') || (p[0] == '\r') || (sscanf(p, "%2x", &value) != 1)) break;
+      frame.data[len++] = (char)value;
+    }
+    if (len != FRAMESIZE) {
+      fprintf(stderr, "%s:%u: expected %d bytes, got %u\n", path, lineno, FRAMESIZE, len);
+      fclose(fp);
+      return false;
+    }
+    frames.push_back(frame);
+  }
+  fclose(fp);
+  return frames.size() > 0;
+}
+
+static void resetDecoder(void) {
+  setMqttTopicPrefix(&mqttTopicBase, mqtt_topic_base, 0);
+  setMqttTopicPrefix(&mqttTopicValues, mqtt_topic_base, mqtt_topic_values);
+  setTopicFilters(topicFilterSetting, log_message);
+  memset(actData, 0, sizeof(actData));
+  hostbench_millis = 1;
+  hostbench_micros = 1000;
+}
+
+static void decodeFrame(const frameStruct &frame) {
+  char data[FRAMESIZE];
+  memcpy(data, frame.data, FRAMESIZE);
+  hostbench_millis += POLLTIME;
+  hostbench_micros += POLLTIME * 1000UL;
+  if (heatpumpDataUnchanged(data)) { //as read_panasonic_data does
+    skippedFrames++;
+    return;
+  }
+  decode_heatpump_data(data, actData, mqtt_client, log_message, &mqttTopicValues, &mqttTopicBase, updateAllTime, mqttPublishTopics, mqttPublishJson);
+}
+
+static int runGolden(void) {
+  resetDecoder();
+  mqtt_client.onPublish = printPublish;
+  for (unsigned int i = 0; i < frames.size(); i++) {
+    printf("frame %u\n", i);
+    decodeFrame(frames[i]);
+  }
+  return 0;
+}
+
+static double now(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int runBench(unsigned int passes) {
+  resetDecoder();
+  mqtt_client.onPublish = 0;
+  unsigned long decoded = 0;
+  mqtt_client.publishes = 0;
+  mqtt_client.publishedBytes = 0;
+  logMessages = 0;
+  skippedFrames = 0;
+  allocations = 0;
+  unsigned long startVersion = getDataVersion(DATA_HEATPUMP);
+  countAllocations = true;
+  double elapsed = 0;
+  double bestpass = 0;
+  for (unsigned int pass = 0; pass < passes; pass++) {
+    double start = now();
+    for (unsigned int i = 0; i < frames.size(); i++) {
+      decodeFrame(frames[i]);
+      decoded++;
+    }
+    double passtime = now() - start;
+    elapsed += passtime;
+    if ((pass == 0) || (passtime < bestpass)) bestpass = passtime;
+  }
+  countAllocations = false;
+
+  printf("frames replayed     : %lu (%u passes of %u frames)\n", decoded, passes, (unsigned int)frames.size());
+  printf("frames/sec          : %.0f\n", decoded / elapsed);
+  printf("usec/frame          : %.3f (best pass %.3f)\n", (elapsed * 1e6) / decoded, (bestpass * 1e6) / frames.size());
+  printf("allocations/frame   : %.2f\n", (double)allocations / decoded);
+  printf("publishes/frame     : %.2f\n", (double)mqtt_client.publishes / decoded);
+  printf("published bytes/frame: %.1f\n", (double)mqtt_client.publishedBytes / decoded);
+  printf("log messages/frame  : %.2f\n", (double)logMessages / decoded);
+  printf("identical, skipped  : %.1f%% of the frames\n", 100.0 * skippedFrames / decoded);
+  printf("data version moved  : %.1f%% of the frames (the others answer a web poll with 304)\n", 100.0 * (getDataVersion(DATA_HEATPUMP) - startVersion) / decoded);
+  return 0;
+}
+
+// the publish path before the precomputed topic prefix, every publish printed its topic, value and log message
+static char *legacyFormatTopicValue(unsigned int topic, int32_t value, char *buffer, byte type) {
+  const char *sign = (value < 0) ? "-" : "";
+  int32_t absvalue = (value < 0) ? -value : value;
+  switch (type) {
+    case TOPIC_TYPE_DEC1:
+      sprintf(buffer, "%s%d.%01d", sign, (int)(absvalue / 10), (int)(absvalue % 10));
+      break;
+    case TOPIC_TYPE_DEC2:
+      sprintf(buffer, "%s%d.%02d", sign, (int)(absvalue / 100), (int)(absvalue % 100));
+      break;
+    case TOPIC_TYPE_ERROR:
+      if (value == 0) {
+        sprintf(buffer, "No error");
+      } else {
+        sprintf(buffer, "%c%02X", (char)(value >> 16), (int)(int16_t)(value & 0xFFFF));
+      }
+      break;
+    default:
+      sprintf(buffer, "%d", (int)value);
+      break;
+  }
+  return buffer;
+}
+
+static unsigned long long cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+static int runPublish(unsigned int passes) {
+  //decode every topic of every frame once, the publish path is then timed on these values
+  resetDecoder();
+  std::vector<int32_t> values;
+  for (unsigned int i = 0; i < frames.size(); i++) {
+    decodeFrame(frames[i]);
+    values.insert(values.end(), actData, actData + NUMBER_OF_TOPICS);
+  }
+  char names[NUMBER_OF_TOPICS][TOPIC_NAME_SIZE];
+  byte types[NUMBER_OF_TOPICS];
+  for (unsigned int t = 0; t < NUMBER_OF_TOPICS; t++) {
+    getTopicName(t, names[t]);
+    types[t] = pgm_read_byte(&topicDescriptors[t].type);
+  }
+
+  //both paths have to produce the same topic, value and log message
+  unsigned int mismatches = 0;
+  for (unsigned int i = 0; i < values.size(); i++) {
+    unsigned int t = i % NUMBER_OF_TOPICS;
+    char oldValue[TOPIC_VALUE_TEXT_SIZE], newValue[TOPIC_VALUE_TEXT_SIZE], oldTopic[256];
+    legacyFormatTopicValue(t, values[i], oldValue, types[t]);
+    formatTopicValue(t, values[i], newValue);
+    sprintf(oldTopic, "%s/%s/%s", mqtt_topic_base, mqtt_topic_values, names[t]);
+    if ((strcmp(oldValue, newValue) != 0) || (strcmp(oldTopic, getMqttTopic(&mqttTopicValues, names[t])) != 0)) mismatches++;
+  }
+  for (int32_t v = -100000; v <= 100000; v++) {
+    char oldValue[TOPIC_VALUE_TEXT_SIZE], newValue[TOPIC_VALUE_TEXT_SIZE];
+    for (unsigned int t : {0, 1, 64}) { //integer, two decimals and one decimal
+      if (strcmp(legacyFormatTopicValue(t, v, oldValue, types[t]), formatTopicValue(t, v, newValue)) != 0) mismatches++;
+    }
+  }
+
+  char log_msg[256];
+  char valueText[TOPIC_VALUE_TEXT_SIZE];
+  unsigned long checksum = 0;
+  unsigned long publishes = (unsigned long)passes * values.size();
+
+  double start = now();
+  unsigned long long startCycles = cycles();
+  for (unsigned int pass = 0; pass < passes; pass++) {
+    for (unsigned int i = 0; i < values.size(); i++) {
+      unsigned int t = i % NUMBER_OF_TOPICS;
+      char mqtt_topic[256];
+      legacyFormatTopicValue(t, values[i], valueText, types[t]);
+      sprintf(log_msg, "received TOP%d %s: %s", t, names[t], valueText);
+      sprintf(mqtt_topic, "%s/%s/%s", mqtt_topic_base, mqtt_topic_values, names[t]);
+      checksum += mqtt_topic[strlen(mqtt_topic) - 1] + valueText[0] + log_msg[13];
+    }
+  }
+  double legacyTime = now() - start;
+  double legacyCycles = cycles() - startCycles;
+
+  start = now();
+  startCycles = cycles();
+  for (unsigned int pass = 0; pass < passes; pass++) {
+    for (unsigned int i = 0; i < values.size(); i++) {
+      unsigned int t = i % NUMBER_OF_TOPICS;
+      formatTopicValue(t, values[i], valueText);
+      strcpy(log_msg, "received TOP");
+      char *log_end = formatUnsigned(t, &log_msg[strlen(log_msg)]);
+      *log_end++ = ' ';
+      strcpy(log_end, names[t]);
+      strcat(log_end, ": ");
+      strcat(log_end, valueText);
+      char *mqtt_topic = getMqttTopic(&mqttTopicValues, names[t]);
+      checksum -= mqtt_topic[strlen(mqtt_topic) - 1] + valueText[0] + log_msg[13];
+    }
+  }
+  double newTime = now() - start;
+  double newCycles = cycles() - startCycles;
+
+  printf("publishes timed     : %lu (%u passes of %u values)\n", publishes, passes, (unsigned int)values.size());
+  printf("output mismatches   : %u%s\n", mismatches, checksum ? " (checksum differs)" : "");
+  printf("sprintf             : %.1f nsec/publish, %.0f cycles/publish\n", legacyTime * 1e9 / publishes, legacyCycles / publishes);
+  printf("prefix + integer    : %.1f nsec/publish, %.0f cycles/publish\n", newTime * 1e9 / publishes, newCycles / publishes);
+  printf("saved               : %.1f nsec/publish, %.0f cycles/publish\n", (legacyTime - newTime) * 1e9 / publishes, (legacyCycles - newCycles) / publishes);
+  return (mismatches == 0) ? 0 : 1;
+}
+
+// the readSerial() logic before the resynchronising frame parser, kept to compare the recovery rate
+struct legacyReaderStruct {
+  char data[FRAMEPARSERMAXFRAMESIZE];
+  unsigned int data_length = 0;
+};
+
+static bool legacyReadSerial(legacyReaderStruct *reader, const byte *stream, unsigned int available, unsigned int *pos, char *frame) {
+  while ((*pos < available) && (reader->data_length < FRAMEPARSERMAXFRAMESIZE)) {
+    reader->data[reader->data_length++] = stream[(*pos)++];
+    if ((byte)reader->data[0] != 113) {
+      reader->data_length = 0;
+      return false;
+    }
+  }
+  if (reader->data_length > 1) {
+    unsigned int length = (byte)reader->data[1] + 3;
+    if ((reader->data_length > length) || (reader->data_length >= FRAMEPARSERMAXFRAMESIZE)) {
+      reader->data_length = 0;
+      return false;
+    }
+    if (reader->data_length == length) {
+      byte chk = 0;
+      for (unsigned int i = 0; i < length; i++) chk += reader->data[i];
+      reader->data_length = 0;
+      if (chk != 0) return false;
+      memcpy(frame, reader->data, length);
+      return true;
+    }
+  }
+  return false;
+}
+
+static int runParser(unsigned int percent) {
+  srand(203);
+  std::vector<byte> stream;
+  std::vector<bool> intact;
+  unsigned int garbage = 0, flipped = 0, dropped = 0;
+  for (unsigned int i = 0; i < frames.size(); i++) {
+    const byte *frame = (const byte *)frames[i].data;
+    bool ok = true;
+    for (unsigned int n = 0; n < frames[i].prefixLength; n++) stream.push_back(frames[i].prefix[n]);
+    if ((unsigned int)(rand() % 100) < percent) { //noise on the line before the frame
+      unsigned int noise = 1 + rand() % 16;
+      for (unsigned int n = 0; n < noise; n++) stream.push_back(rand() & 0xFF);
+      garbage++;
+    }
+    unsigned int corrupt = ((unsigned int)(rand() % 100) < percent) ? 1 + rand() % 2 : 0;
+    unsigned int where = 2 + rand() % (FRAMESIZE - 2);
+    for (unsigned int b = 0; b < FRAMESIZE; b++) {
+      if ((corrupt == 1) && (b == where)) { //bit error
+        stream.push_back(frame[b] ^ (1 << (rand() % 8)));
+        continue;
+      }
+      if ((corrupt == 2) && (b == where)) continue; //lost byte
+      stream.push_back(frame[b]);
+    }
+    if (corrupt == 1) flipped++;
+    if (corrupt == 2) dropped++;
+    if (corrupt) ok = false;
+    intact.push_back(ok);
+  }
+
+  //the stream arrives in chunks, as it does between two calls of loop()
+  std::vector<unsigned int> chunks;
+  for (unsigned int pos = 0; pos < stream.size(); ) {
+    unsigned int chunk = 1 + rand() % 48;
+    if (pos + chunk > stream.size()) chunk = stream.size() - pos;
+    chunks.push_back(chunk);
+    pos += chunk;
+  }
+
+  unsigned int intactFrames = 0;
+  for (unsigned int i = 0; i < intact.size(); i++) if (intact[i]) intactFrames++;
+
+  //count a frame as recovered when it is byte for byte one of the intact corpus frames, in order
+  char frame[FRAMEPARSERMAXFRAMESIZE];
+  unsigned int recovered = 0, next = 0;
+  auto matchFrame = [&](unsigned int length) {
+    if (length != FRAMESIZE) return;
+    for (unsigned int i = next; i < frames.size(); i++) {
+      if (intact[i] && (memcmp(frame, frames[i].data, FRAMESIZE) == 0)) {
+        recovered++;
+        next = i + 1;
+        return;
+      }
+    }
+  };
+
+  frameParserStruct parser;
+  unsigned int pos = 0;
+  for (unsigned int c = 0; c < chunks.size(); c++) {
+    for (unsigned int b = 0; b < chunks[c]; b++) frameParserPush(&parser, stream[pos++]);
+    byte length = 0, result;
+    while ((result = frameParserParse(&parser, frame, &length)) != FRAME_INCOMPLETE) {
+      if (result == FRAME_OK) matchFrame(length);
+    }
+  }
+  unsigned int parserRecovered = recovered;
+
+  legacyReaderStruct reader;
+  recovered = 0;
+  next = 0;
+  pos = 0;
+  unsigned int available = 0;
+  for (unsigned int c = 0; c < chunks.size(); c++) {
+    available += chunks[c];
+    while (pos < available) {
+      if (legacyReadSerial(&reader, stream.data(), available, &pos, frame)) matchFrame(FRAMESIZE);
+    }
+  }
+  unsigned int legacyRecovered = recovered;
+
+  printf("stream bytes        : %u\n", (unsigned int)stream.size());
+  printf("frames              : %u (%u with noise before, %u with a bit error, %u with a lost byte)\n", (unsigned int)frames.size(), garbage, flipped, dropped);
+  printf("intact frames       : %u\n", intactFrames);
+  printf("frame parser        : %u recovered (%.1f%%), %lu bad checksums, %lu bad lengths, %lu skipped bytes\n", parserRecovered, 100.0 * parserRecovered / intactFrames, parser.badChecksums, parser.badLengths, parser.skippedBytes);
+  printf("old readSerial      : %u recovered (%.1f%%)\n", legacyRecovered, 100.0 * legacyRecovered / intactFrames);
+
+  //each frame as the answer to a send, a bad checksum only ends the transaction when it started at the first
+  //header after the send, ending it while the answer is still coming in lets the next send collide with it
+  unsigned int early = 0, legacyEarly = 0;
+  for (unsigned int i = 0; i < frames.size(); i++) {
+    std::vector<byte> answer(frames[i].prefix, frames[i].prefix + frames[i].prefixLength);
+    answer.insert(answer.end(), (const byte *)frames[i].data, (const byte *)frames[i].data + FRAMESIZE);
+    frameParserReset(&parser);
+    frameParserExpectAnswer(&parser);
+    bool ended = false, legacyEnded = false;
+    for (unsigned int b = 0; (b < answer.size()) && !ended; b++) {
+      frameParserPush(&parser, answer[b]);
+      byte length = 0, result;
+      bool last = (b == answer.size() - 1);
+      while ((result = frameParserParse(&parser, frame, &length)) != FRAME_INCOMPLETE) {
+        if (result == FRAME_BAD_CHECKSUM) {
+          if (!legacyEnded && !last) legacyEarly++;
+          legacyEnded = true;
+          if (!frameParserFirstHeader(&parser)) continue;
+        }
+        if ((result == FRAME_OK) || (result == FRAME_BAD_CHECKSUM)) {
+          if (!last) early++;
+          ended = true;
+          break;
+        }
+      }
+    }
+  }
+  printf("answers ended early : %u (%u when any bad checksum ends the answer)\n", early, legacyEarly);
+  return (early == 0) ? 0 : 1;
+}
+
+// Bursts of set commands as an automation sends them, each burst arrives within a few millis. The
+// command buffer is compared against sending every command in its own frame.
+struct commandBurstStruct {
+  const char *name;
+  const char *value;
+};
+
+static const commandBurstStruct commandBursts[][5] = {
+  { { "SetZ1HeatRequestTemperature", "32" }, { "SetZ1HeatRequestTemperature", "33" }, { "SetZ1HeatRequestTemperature", "34" } },
+  { { "SetZ1HeatRequestTemperature", "35" }, { "SetDHWTemp", "48" }, { "SetQuietMode", "2" } },
+  { { "SetZ1HeatRequestTemperature", "31" }, { "SetZ2HeatRequestTemperature", "29" }, { "SetDHWTemp", "50" }, { "SetQuietMode", "0" } },
+  { { "SetQuietMode", "1" }, { "SetPowerfulMode", "1" } },
+  { { "SetHeatpump", "1" } },
+};
+#define NUMBER_OF_COMMANDBURSTS (sizeof(commandBursts) / sizeof(commandBursts[0]))
+#define BUSTRANSACTIONTIME 400 // millis to send a 111 byte set command and receive the 203 byte answer at 9600 baud
+
+static commandQueueStruct commandBuffer;
+static bool commandSending = false;
+static unsigned long commandTransactions = 0;
+static unsigned long legacyTransactions = 0;
+
+static void writeCommand(void) {
+  commandTransactions++;
+  commandSending = true;
+  hostbench_millis += BUSTRANSACTIONTIME;
+  commandQueuePop(&commandBuffer);
+  commandSending = false;
+}
+
+// same as send_command in HeishaMon.ino without the serial port, everything goes through the buffer
+static bool queueCommand(byte *command, int length, byte key) {
+  legacyTransactions++;
+  commandQueuePush(&commandBuffer, command, length, key);
+  return false;
+}
+
+static int runCommands(unsigned int rounds) {
+  hostbench_millis = 0;
+  unsigned long commands = 0;
+  for (unsigned int round = 0 ; round < rounds ; round++) {
+    for (unsigned int burst = 0 ; burst < NUMBER_OF_COMMANDBURSTS ; burst++) {
+      for (unsigned int i = 0 ; (i < 5) && (commandBursts[burst][i].name != NULL) ; i++) {
+        char msg[16];
+        strcpy(msg, commandBursts[burst][i].value);
+        send_heatpump_command(findCommand(commandBursts[burst][i].name), msg, queueCommand, log_message);
+        commands++;
+        hostbench_millis += 5;
+      }
+      //the loop() of HeishaMon.ino until the buffer is empty
+      while (commandBuffer.count > 0) {
+        if (commandQueueReady(&commandBuffer)) {
+          commandQueueMerge(&commandBuffer);
+          writeCommand();
+        } else {
+          hostbench_millis += 10;
+        }
+      }
+      hostbench_millis += 60000;
+    }
+  }
+  printf("set commands        : %lu in %u bursts\n", commands, rounds * (unsigned int)NUMBER_OF_COMMANDBURSTS);
+  printf("one frame each      : %lu bus transactions\n", legacyTransactions);
+  printf("command buffer      : %lu bus transactions (%lu coalesced, %lu merged, %.0f%% saved)\n", commandTransactions, commandBuffer.coalesced, commandBuffer.merged, 100.0 * (legacyTransactions - commandTransactions) / legacyTransactions);
+
+  //set, raw, set: the second set command may not be merged into the first and so overtake the raw command
+  char msg[16];
+  byte raw[] = { 0x71, 0x6c, 0x01, 0x10 };
+  strcpy(msg, "48");
+  send_heatpump_command(findCommand("SetDHWTemp"), msg, queueCommand, log_message);
+  queueCommand(raw, sizeof(raw), COMMAND_KEY_NONE);
+  strcpy(msg, "1");
+  send_heatpump_command(findCommand("SetQuietMode"), msg, queueCommand, log_message);
+  char order[8];
+  unsigned int sent = 0;
+  while ((commandBuffer.count > 0) && (sent < sizeof(order) - 1)) {
+    if (commandQueueReady(&commandBuffer)) {
+      commandQueueMerge(&commandBuffer);
+      order[sent++] = (commandQueuePeek(&commandBuffer)->key == COMMAND_KEY_NONE) ? 'r' : 's';
+      writeCommand();
+    } else {
+      hostbench_millis += 10;
+    }
+  }
+  order[sent] = '\0';
+  bool inOrder = (strcmp(order, "srs") == 0);
+  printf("set, raw, set       : sent as %s, %s\n", order, inOrder ? "in order of arrival" : "NOT in order of arrival");
+  return inOrder ? 0 : 1;
+}
+
+// An hour of bus traffic: a panasonic query every interval, an optional pcb query every 5 seconds and a
+// user command at pseudo random moments, about twice a minute. The old loop() sends both queries back to
+// back every interval and every command waits behind them, the bus scheduler sends commands first.
+#define OPTIONALPCBTRANSACTIONTIME 100 // millis to send the 19 byte optional pcb query and receive its 20 byte answer
+#define SIMULATIONTIME 3600000
+#define SIMULATIONSTEP 10
+
+struct schedulerSimulationStruct {
+  unsigned long polls = 0;
+  unsigned long commands = 0;
+  unsigned long commandWait = 0;
+  unsigned long maxCommandWait = 0;
+  unsigned long busyTime = 0;
+  unsigned long maxOptionalPCBGap = 0;
+};
+
+static void simulateCommand(schedulerSimulationStruct *sim, unsigned long arrival) {
+  unsigned long wait = hostbench_millis - arrival;
+  sim->commands++;
+  sim->commandWait += wait;
+  if (wait > sim->maxCommandWait) sim->maxCommandWait = wait;
+}
+
+static void printSimulation(const char *name, schedulerSimulationStruct *sim) {
+  printf("%-20s: %.1f%% bus utilisation, %.1f polls/min, command wait %.0f msec average %lu msec max, optional pcb gap %lu msec max\n", name,
+         100.0 * sim->busyTime / SIMULATIONTIME, sim->polls * 60000.0 / SIMULATIONTIME, (double)sim->commandWait / sim->commands, sim->maxCommandWait, sim->maxOptionalPCBGap);
+}
+
+static int runScheduler(unsigned long interval) {
+  unsigned long arrivals[256];
+  unsigned int numberOfArrivals = 0;
+  srand(1);
+  for (unsigned long time = rand() % 60000 ; (time < SIMULATIONTIME) && (numberOfArrivals < 256) ; time += rand() % 60000) arrivals[numberOfArrivals++] = time;
+
+  //old loop(): both queries every interval, commands buffered behind whatever is on the bus or buffered
+  schedulerSimulationStruct legacy;
+  {
+    byte queue[512]; // 0 is the panasonic query, 1 the optional pcb query, 2 a command
+    unsigned long queueArrival[512];
+    unsigned int head = 0, tail = 0, arrival = 0;
+    unsigned long nexttime = 0, busyUntil = 0, lastOptionalPCB = 0;
+    for (hostbench_millis = 0 ; hostbench_millis < SIMULATIONTIME ; hostbench_millis += SIMULATIONSTEP) {
+      if ((arrival < numberOfArrivals) && (hostbench_millis >= arrivals[arrival])) {
+        queueArrival[tail % 512] = arrivals[arrival++];
+        queue[tail++ % 512] = 2;
+      }
+      if (hostbench_millis >= nexttime) {
+        nexttime = hostbench_millis + interval;
+        queueArrival[tail % 512] = hostbench_millis;
+        queue[tail++ % 512] = 0;
+        queueArrival[tail % 512] = hostbench_millis;
+        queue[tail++ % 512] = 1;
+      }
+      if ((hostbench_millis >= busyUntil) && (head != tail)) {
+        byte next = queue[head % 512];
+        if (next == 2) simulateCommand(&legacy, queueArrival[head % 512]);
+        if (next == 0) legacy.polls++;
+        if (next == 1) {
+          if (hostbench_millis - lastOptionalPCB > legacy.maxOptionalPCBGap) legacy.maxOptionalPCBGap = hostbench_millis - lastOptionalPCB;
+          lastOptionalPCB = hostbench_millis;
+        }
+        unsigned long duration = (next == 1) ? OPTIONALPCBTRANSACTIONTIME : BUSTRANSACTIONTIME;
+        busyUntil = hostbench_millis + duration;
+        legacy.busyTime += duration;
+        head++;
+      }
+    }
+  }
+
+  //bus scheduler
+  schedulerSimulationStruct scheduled;
+  {
+    busSchedulerStruct scheduler;
+    hostbench_millis = 0;
+    busSchedulerInit(&scheduler, interval);
+    unsigned long queueArrival[256];
+    unsigned int head = 0, tail = 0, arrival = 0;
+    unsigned long busyUntil = 0, lastOptionalPCB = 0;
+    for (hostbench_millis = 0 ; hostbench_millis < SIMULATIONTIME ; hostbench_millis += SIMULATIONSTEP) {
+      if ((arrival < numberOfArrivals) && (hostbench_millis >= arrivals[arrival])) queueArrival[tail++ % 256] = arrivals[arrival++];
+      bool sending = hostbench_millis < busyUntil;
+      busSchedulerUpdate(&scheduler, sending);
+      if (sending) continue;
+      unsigned long duration = 0;
+      switch (busSchedulerNext(&scheduler, head != tail, head != tail, true)) {
+        case BUS_COMMAND: {
+            simulateCommand(&scheduled, queueArrival[head++ % 256]);
+            duration = BUSTRANSACTIONTIME;
+          } break;
+        case BUS_OPTIONALPCB: {
+            if (hostbench_millis - lastOptionalPCB > scheduled.maxOptionalPCBGap) scheduled.maxOptionalPCBGap = hostbench_millis - lastOptionalPCB;
+            lastOptionalPCB = hostbench_millis;
+            duration = OPTIONALPCBTRANSACTIONTIME;
+          } break;
+        case BUS_POLL: {
+            scheduled.polls++;
+            duration = BUSTRANSACTIONTIME;
+          } break;
+      }
+      busyUntil = hostbench_millis + duration;
+      scheduled.busyTime += duration;
+    }
+    printf("measured utilisation: %.1f%% (busSchedulerMeasure)\n", busSchedulerMeasure(&scheduler));
+  }
+
+  printf("simulated           : 1 hour, panasonic query every %lu msec, optional pcb query, %u commands\n", interval, numberOfArrivals);
+  printSimulation("old loop()", &legacy);
+  printSimulation("bus scheduler", &scheduled);
+  return 0;
+}
+
+// The mqtt_callback and send_heatpump_command dispatch before the sorted command topics: strcmp/strncmp
+// against the raw, pcb and s0 topics and a linear search of the commands and optional pcb topics.
+static char legacyCommandNames[NUMBER_OF_COMMANDS][COMMAND_NAME_SIZE];
+
+static bool legacyFindCommandTopic(const char *topic_command, byte *kind, byte *index) {
+  if (strcmp(topic_command, "SendRawValue") == 0) {
+    *kind = COMMAND_TOPIC_RAW;
+    *index = 0;
+    return true;
+  } else if (strncmp(topic_command, "pcb/#", 4) == 0) {
+    for (int i = 0 ; i < NUMBER_OF_OPTIONALPCB_TOPICS ; i++) {
+      if (strcmp(&topic_command[4], optionalPcbTopics[i]) == 0) {
+        *kind = COMMAND_TOPIC_PCB;
+        *index = i;
+        return true;
+      }
+    }
+    return false;
+  } else if (strncmp(topic_command, "s0", 2) == 0) {
+    *kind = COMMAND_TOPIC_S0;
+    *index = atoi(&topic_command[17]);
+    return true;
+  }
+  for (int i = 0 ; i < NUMBER_OF_COMMANDS ; i++) {
+    if (strcmp(topic_command, legacyCommandNames[i]) == 0) {
+      *kind = COMMAND_TOPIC_SET;
+      *index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static int runDispatch(unsigned int passes) {
+  std::vector<const char *> topics;
+  for (unsigned int i = 0 ; i < NUMBER_OF_COMMAND_TOPICS ; i++) topics.push_back(commandTopics[i].name);
+  topics.push_back("SetUnknown");
+  topics.push_back("pcb/Unknown");
+  for (unsigned int i = 0 ; i < NUMBER_OF_COMMANDS ; i++) getCommandName(i, legacyCommandNames[i]);
+
+  unsigned int mismatches = 0;
+  for (unsigned int i = 0 ; i < topics.size() ; i++) {
+    byte legacyKind = 255, legacyIndex = 255, kind = 255, index = 255;
+    bool legacyFound = legacyFindCommandTopic(topics[i], &legacyKind, &legacyIndex);
+    bool found = findCommandTopic(topics[i], &kind, &index);
+    if ((legacyFound != found) || (found && ((legacyKind != kind) || (legacyIndex != index)))) {
+      printf("mismatch            : %s\n", topics[i]);
+      mismatches++;
+    }
+  }
+
+  unsigned long lookups = (unsigned long)passes * topics.size();
+  unsigned long checksum = 0;
+  byte kind, index;
+  double start = now();
+  unsigned long long startCycles = cycles();
+  for (unsigned int pass = 0; pass < passes; pass++) {
+    for (unsigned int i = 0; i < topics.size(); i++) {
+      if (legacyFindCommandTopic(topics[i], &kind, &index)) checksum += index;
+    }
+  }
+  double legacyTime = now() - start;
+  double legacyCycles = cycles() - startCycles;
+
+  start = now();
+  startCycles = cycles();
+  for (unsigned int pass = 0; pass < passes; pass++) {
+    for (unsigned int i = 0; i < topics.size(); i++) {
+      if (findCommandTopic(topics[i], &kind, &index)) checksum -= index;
+    }
+  }
+  double newTime = now() - start;
+  double newCycles = cycles() - startCycles;
+
+  printf("lookups timed       : %lu (%u passes of %u topics)\n", lookups, passes, (unsigned int)topics.size());
+  printf("result mismatches   : %u%s\n", mismatches, checksum ? " (checksum differs)" : "");
+  printf("strcmp chain        : %.1f nsec/lookup, %.0f cycles/lookup\n", legacyTime * 1e9 / lookups, legacyCycles / lookups);
+  printf("sorted topics       : %.1f nsec/lookup, %.0f cycles/lookup\n", newTime * 1e9 / lookups, newCycles / lookups);
+  return (mismatches == 0) ? 0 : 1;
+}
+
+// The /json response of handleJsonOutput, with the 1wire and s0 values of a unit with 3 sensors and both s0 ports
+struct benchDallasStruct {
+  const char *address;
+  float temperature;
+};
+static const benchDallasStruct benchDallas[] = { { "28ff4a1c6016034e", 21.5 }, { "28ff9b2d7016045f", 45.25 }, { "28ffc13e80160560", -2.75 } };
+#define BENCH_DALLAS (sizeof(benchDallas) / sizeof(benchDallas[0]))
+static const unsigned int benchS0Watt[2] = { 1450, 0 };
+static const unsigned int benchS0Pulses[2] = { 27, 0 };
+static const unsigned int benchS0Ppkwh[2] = { 1000, 1000 };
+
+// handleJsonOutput, dallasJsonOutput and s0JsonOutput before the json writer: String concatenation
+static void legacyJsonOutput(ESP8266WebServer *httpServer) {
+  httpServer->setContentLength(CONTENT_LENGTH_UNKNOWN);
+  httpServer->sendHeader("Access-Control-Allow-Origin", "*");
+  httpServer->send(200, "application/json", "");
+  String tabletext = "{";
+  tabletext = tabletext + "\"heatpump\":[";
+  httpServer->sendContent(tabletext);
+  char valueText[TOPIC_VALUE_TEXT_SIZE];
+  char topicName[TOPIC_NAME_SIZE];
+  char topicDesc[TOPIC_DESCRIPTION_TEXT_SIZE];
+  for (unsigned int topic = 0 ; topic < NUMBER_OF_TOPICS ; topic++) {
+    tabletext = "{";
+    tabletext = tabletext + "\"Topic\": \"TOP" + topic + "\",";
+    tabletext = tabletext + "\"Name\": \"" + getTopicName(topic, topicName) + "\",";
+    tabletext = tabletext + "\"Value\": \"" + formatTopicValue(topic, actData[topic], valueText) + "\",";
+    tabletext = tabletext + "\"Description\": \"" + getTopicDescription(topic, actData[topic], topicDesc) + "\"";
+    tabletext = tabletext + "}";
+    if (topic < NUMBER_OF_TOPICS - 1) tabletext = tabletext + ",";
+    httpServer->sendContent(tabletext);
+  }
+  tabletext = "]";
+  httpServer->sendContent(tabletext);
+  String dallas = "[";
+  for (unsigned int i = 0; i < BENCH_DALLAS; i++) {
+    dallas = dallas + "{";
+    dallas = dallas + "\"Sensor\": \"" + benchDallas[i].address + "\",";
+    dallas = dallas + "\"Temperature\": \"" + benchDallas[i].temperature + "\"";
+    dallas = dallas + "}";
+    if (i < BENCH_DALLAS - 1) dallas = dallas + ",";
+  }
+  dallas = dallas + "]";
+  tabletext =  ",\"1wire\":" + dallas;
+  httpServer->sendContent(tabletext);
+  String s0 = "[";
+  for (int i = 0; i < 2; i++) {
+    s0 = s0 + "{";
+    s0 = s0 + "\"S0 port\": \"" + (i + 1) + "\",";
+    s0 = s0 + "\"Watt\": \"" + benchS0Watt[i] + "\",";
+    s0 = s0 + "\"Watthour\": \"" + (benchS0Pulses[i] * ( 1000.0 / benchS0Ppkwh[i])) + "\"";
+    s0 = s0 + "}";
+    if (i < 2 - 1) s0 = s0 + ",";
+  }
+  s0 = s0 + "]";
+  tabletext =  ",\"s0\":" + s0;
+  httpServer->sendContent(tabletext);
+  tabletext = "}";
+  httpServer->sendContent(tabletext);
+  httpServer->sendContent("");
+  httpServer->client().stop();
+}
+
+// handleJsonOutput, dallasJsonOutput and s0JsonOutput with the json writer
+static void streamJsonOutput(ESP8266WebServer *httpServer) {
+  jsonWriterStruct json;
+  char valueText[TOPIC_VALUE_TEXT_SIZE];
+  char topicName[TOPIC_NAME_SIZE];
+  char topicDesc[TOPIC_DESCRIPTION_TEXT_SIZE];
+  char topicText[16] = "TOP";
+  jsonBegin(&json, httpServer);
+  jsonArrayBegin(&json, "heatpump");
+  for (unsigned int topic = 0 ; topic < NUMBER_OF_TOPICS ; topic++) {
+    formatUnsigned(topic, &topicText[3]);
+    jsonObjectBegin(&json, 0);
+    jsonString(&json, "Topic", topicText);
+    jsonString(&json, "Name", getTopicName(topic, topicName));
+    jsonString(&json, "Value", formatTopicValue(topic, actData[topic], valueText));
+    jsonString(&json, "Description", getTopicDescription(topic, actData[topic], topicDesc));
+    jsonObjectEnd(&json);
+  }
+  jsonArrayEnd(&json);
+  jsonArrayBegin(&json, "1wire");
+  for (unsigned int i = 0; i < BENCH_DALLAS; i++) {
+    jsonObjectBegin(&json, 0);
+    jsonString(&json, "Sensor", benchDallas[i].address);
+    formatDecimal(lrintf(benchDallas[i].temperature * 100), 2, valueText);
+    jsonString(&json, "Temperature", valueText);
+    jsonObjectEnd(&json);
+  }
+  jsonArrayEnd(&json);
+  jsonArrayBegin(&json, "s0");
+  for (int i = 0; i < 2; i++) {
+    jsonObjectBegin(&json, 0);
+    formatUnsigned(i + 1, valueText);
+    jsonString(&json, "S0 port", valueText);
+    formatUnsigned(benchS0Watt[i], valueText);
+    jsonString(&json, "Watt", valueText);
+    formatDecimal((benchS0Pulses[i] * 100000 + benchS0Ppkwh[i] / 2) / benchS0Ppkwh[i], 2, valueText);
+    jsonString(&json, "Watthour", valueText);
+    jsonObjectEnd(&json);
+  }
+  jsonArrayEnd(&json);
+  jsonEnd(&json);
+}
+
+// the old output has a space after the colon within the objects, the json writer writes none
+static unsigned int compactJson(const char *json, unsigned int length, char *compact) {
+  unsigned int size = 0;
+  for (unsigned int i = 0 ; i < length ; i++) {
+    if ((json[i] == ' ') && (i > 1) && (json[i - 1] == ':') && (json[i - 2] == '"')) continue;
+    compact[size++] = json[i];
+  }
+  return size;
+}
+
+static int runJson(void) {
+  static ESP8266WebServer httpServer;
+  static char legacyResponse[HOSTBENCH_RESPONSESIZE];
+  resetDecoder();
+  for (unsigned int i = 0; i < frames.size(); i++) decodeFrame(frames[i]);
+
+  allocations = 0;
+  heapInUse = 0;
+  heapPeak = 0;
+  countAllocations = true;
+  legacyJsonOutput(&httpServer);
+  countAllocations = false;
+  unsigned long legacyAllocations = allocations;
+  long legacyPeak = heapPeak;
+  unsigned int legacyChunks = httpServer.chunks;
+  unsigned int legacyLength = compactJson(httpServer.response, httpServer.length, legacyResponse);
+
+  allocations = 0;
+  heapInUse = 0;
+  heapPeak = 0;
+  countAllocations = true;
+  streamJsonOutput(&httpServer);
+  countAllocations = false;
+
+  bool same = (legacyLength == httpServer.length) && (memcmp(legacyResponse, httpServer.response, legacyLength) == 0);
+  printf("response            : %u bytes, %s\n", httpServer.length, same ? "same json as the String version" : "DIFFERS from the String version");
+  printf("String version      : %lu allocations, peak heap %ld bytes, %u chunks\n", legacyAllocations, legacyPeak, legacyChunks);
+  printf("json writer         : %lu allocations, peak heap %ld bytes, %u chunks (%u bytes buffer on the stack)\n", allocations, heapPeak, httpServer.chunks, (unsigned int)sizeof(jsonWriterStruct));
+
+  // the same heatpump data split in the /meta document, fetched once, and the /values of each poll
+  unsigned int jsonLength = httpServer.length;
+  jsonWriterStruct json;
+  jsonBegin(&json, &httpServer);
+  jsonString(&json, "Version", "hostbench");
+  jsonArrayBegin(&json, "heatpump");
+  topicMetaJsonOutput(&json);
+  jsonArrayEnd(&json);
+  jsonEnd(&json);
+  unsigned int metaLength = httpServer.length;
+  if (getenv("HOSTBENCH_DUMP")) printf("%.*s\n", (int)httpServer.length, httpServer.response);
+  jsonBegin(&json, &httpServer);
+  jsonArrayBegin(&json, "heatpump");
+  topicValuesJsonOutput(&json, actData);
+  jsonArrayEnd(&json);
+  jsonEnd(&json);
+  if (getenv("HOSTBENCH_DUMP")) printf("%.*s\n", (int)httpServer.length, httpServer.response);
+  printf("/meta               : %u bytes, once per firmware version\n", metaLength);
+  printf("/values             : %u bytes per poll, %.1f%% less than /json\n", httpServer.length, 100.0 * (jsonLength - httpServer.length) / jsonLength);
+  return same ? 0 : 1;
+}
+
+static bool setPublish(const char *publish) {
+  mqttPublishTopics = (strncmp(publish, "topics", 6) == 0);
+  if (mqttPublishTopics) publish += (publish[6] == '+') ? 7 : 6;
+  if (publish[0] == '\0') mqttPublishJson = MQTT_JSON_OFF;
+  else if (strcmp(publish, "json") == 0) mqttPublishJson = MQTT_JSON_ALL;
+  else if (strcmp(publish, "delta") == 0) mqttPublishJson = MQTT_JSON_CHANGED;
+  else {
+    fprintf(stderr, "unknown publish mode %s\n", publish);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char **argv) {
+  if (argc < 3) {
+    fprintf(stderr, "usage: %s golden|bench|parser|publish|commands|scheduler|dispatch|json <frames.txt> [passes|percent] [publish]\n", argv[0]);
+    return 1;
+  }
+  if (!loadFrames(argv[2])) return 1;
+  if (strcmp(argv[1], "golden") == 0) {
+    if ((argc > 3) && !setPublish(argv[3])) return 1;
+    if (argc > 4) topicFilterSetting = argv[4];
+    return runGolden();
+  }
+  if (strcmp(argv[1], "bench") == 0) {
+    if ((argc > 4) && !setPublish(argv[4])) return 1;
+    if (argc > 5) topicFilterSetting = argv[5];
+    return runBench((argc > 3) ? atoi(argv[3]) : 100);
+  }
+  if (strcmp(argv[1], "parser") == 0) return runParser((argc > 3) ? atoi(argv[3]) : 10);
+  if (strcmp(argv[1], "publish") == 0) return runPublish((argc > 3) ? atoi(argv[3]) : 20);
+  if (strcmp(argv[1], "scheduler") == 0) return runScheduler((argc > 3) ? atol(argv[3]) : 5000);
+  if (strcmp(argv[1], "dispatch") == 0) return runDispatch((argc > 3) ? atoi(argv[3]) : 100000);
+  if (strcmp(argv[1], "commands") == 0) return runCommands((argc > 3) ? atoi(argv[3]) : 1);
+  if (strcmp(argv[1], "json") == 0) return runJson();
+  fprintf(stderr, "unknown mode %s\n", argv[1]);
+  return 1;
+}
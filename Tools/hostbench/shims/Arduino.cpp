@@ -0,0 +1,239 @@
+/* Host implementation of the Arduino core shim */
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <ESP8266WebServer.h>
+
+unsigned long hostbench_millis = 0;
+unsigned long hostbench_micros = 0;
+
+String::String(const char *cstr) : buffer(0), capacity(0), len(0) {
+  if (cstr) copy(cstr, strlen(cstr));
+}
+
+String::String(const String &str) : buffer(0), capacity(0), len(0) {
+  copy(str.c_str(), str.len);
+}
+
+String::String(const __FlashStringHelper *str) : buffer(0), capacity(0), len(0) {
+  const char *cstr = reinterpret_cast<const char *>(str);
+  if (cstr) copy(cstr, strlen(cstr));
+}
+
+String::String(char c) : buffer(0), capacity(0), len(0) {
+  char buf[2] = { c, 0 };
+  copy(buf, 1);
+}
+
+String::String(int value, unsigned char base) : buffer(0), capacity(0), len(0) {
+  char buf[34];
+  snprintf(buf, sizeof(buf), (base == 16) ? "%x" : "%d", value);
+  copy(buf, strlen(buf));
+}
+
+String::String(unsigned int value, unsigned char base) : buffer(0), capacity(0), len(0) {
+  char buf[34];
+  snprintf(buf, sizeof(buf), (base == 16) ? "%x" : "%u", value);
+  copy(buf, strlen(buf));
+}
+
+String::String(long value, unsigned char base) : buffer(0), capacity(0), len(0) {
+  char buf[34];
+  snprintf(buf, sizeof(buf), (base == 16) ? "%lx" : "%ld", value);
+  copy(buf, strlen(buf));
+}
+
+String::String(unsigned long value, unsigned char base) : buffer(0), capacity(0), len(0) {
+  char buf[34];
+  snprintf(buf, sizeof(buf), (base == 16) ? "%lx" : "%lu", value);
+  copy(buf, strlen(buf));
+}
+
+String::String(float value, unsigned char decimalPlaces) : buffer(0), capacity(0), len(0) {
+  char buf[40];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, (double)value);
+  copy(buf, strlen(buf));
+}
+
+String::String(double value, unsigned char decimalPlaces) : buffer(0), capacity(0), len(0) {
+  char buf[40];
+  snprintf(buf, sizeof(buf), "%.*f", decimalPlaces, value);
+  copy(buf, strlen(buf));
+}
+
+String::~String(void) {
+  free(buffer);
+}
+
+bool String::reserve(unsigned int size) {
+  if (buffer && capacity >= size) return true;
+  char *newbuffer = (char *)realloc(buffer, size + 1);
+  if (!newbuffer) return false;
+  if (!buffer) newbuffer[0] = '\0';
+  buffer = newbuffer;
+  capacity = size;
+  return true;
+}
+
+void String::copy(const char *cstr, unsigned int length) {
+  if (!reserve(length)) return;
+  len = length;
+  memcpy(buffer, cstr, length);
+  buffer[len] = '\0';
+}
+
+void String::append(const char *cstr, unsigned int length) {
+  if (!reserve(len + length)) return;
+  memmove(buffer + len, cstr, length);
+  len += length;
+  buffer[len] = '\0';
+}
+
+String &String::operator =(const String &rhs) {
+  if (this != &rhs) copy(rhs.c_str(), rhs.len);
+  return *this;
+}
+
+String &String::operator =(const char *cstr) {
+  copy(cstr, strlen(cstr));
+  return *this;
+}
+
+String &String::operator +=(const String &rhs) {
+  append(rhs.c_str(), rhs.len);
+  return *this;
+}
+
+String &String::operator +=(const char *cstr) {
+  append(cstr, strlen(cstr));
+  return *this;
+}
+
+String &String::operator +=(char c) {
+  append(&c, 1);
+  return *this;
+}
+
+String &String::operator +=(int value) {
+  return *this += String(value);
+}
+
+String &String::operator +=(unsigned int value) {
+  return *this += String(value);
+}
+
+String &String::operator +=(long value) {
+  return *this += String(value);
+}
+
+String &String::operator +=(unsigned long value) {
+  return *this += String(value);
+}
+
+String &String::operator +=(float value) {
+  return *this += String(value);
+}
+
+String &String::operator +=(double value) {
+  return *this += String(value);
+}
+
+bool String::operator ==(const String &rhs) const {
+  return (len == rhs.len) && (strcmp(c_str(), rhs.c_str()) == 0);
+}
+
+bool String::operator ==(const char *cstr) const {
+  return strcmp(c_str(), cstr) == 0;
+}
+
+long String::toInt(void) const {
+  return atol(c_str());
+}
+
+float String::toFloat(void) const {
+  return atof(c_str());
+}
+
+String operator +(const String &lhs, const String &rhs) {
+  String s(lhs);
+  s += rhs;
+  return s;
+}
+
+String operator +(const String &lhs, const char *rhs) {
+  String s(lhs);
+  s += rhs;
+  return s;
+}
+
+String operator +(const char *lhs, const String &rhs) {
+  String s(lhs);
+  s += rhs;
+  return s;
+}
+
+String operator +(const String &lhs, int rhs) {
+  return lhs + String(rhs);
+}
+
+String operator +(const String &lhs, unsigned int rhs) {
+  return lhs + String(rhs);
+}
+
+String operator +(const String &lhs, long rhs) {
+  return lhs + String(rhs);
+}
+
+String operator +(const String &lhs, unsigned long rhs) {
+  return lhs + String(rhs);
+}
+
+String operator +(const String &lhs, float rhs) {
+  return lhs + String(rhs);
+}
+
+String operator +(const String &lhs, double rhs) {
+  return lhs + String(rhs);
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload, bool retained) {
+  return publish(topic, (const uint8_t *)payload, strlen(payload), retained);
+}
+
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int plength, bool retained) {
+  publishes++;
+  publishedBytes += strlen(topic) + plength;
+  if (onPublish) onPublish(topic, (const char *)payload, plength, retained);
+  return true;
+}
+
+bool PubSubClient::beginPublish(const char *topic, unsigned int plength, bool retained) {
+  if ((strlen(topic) >= sizeof(streamTopic)) || (plength > sizeof(streamPayload))) return false;
+  strcpy(streamTopic, topic);
+  streamLength = 0;
+  streamExpected = plength;
+  streamRetained = retained;
+  return true;
+}
+
+size_t PubSubClient::write(const uint8_t *buffer, size_t size) {
+  if (streamLength + size > streamExpected) size = streamExpected - streamLength;
+  memcpy(&streamPayload[streamLength], buffer, size);
+  streamLength += size;
+  return size;
+}
+
+int PubSubClient::endPublish(void) {
+  if (streamLength != streamExpected) {
+    fprintf(stderr, "streamed publish to %s announced %u bytes but wrote %u\n", streamTopic, streamExpected, streamLength);
+    abort();
+  }
+  return publish(streamTopic, (const uint8_t *)streamPayload, streamLength, streamRetained) ? 1 : 0;
+}
+
+void ESP8266WebServer::sendContent(const char *content, size_t size) {
+  if (size == 0) return; //the end of the chunked response
+  chunks++;
+  if (length + size > sizeof(response)) size = sizeof(response) - length;
+  memcpy(&response[length], content, size);
+  length += size;
+}
@@ -0,0 +1,127 @@
+/* Minimal Arduino core shim so the HeishaMon decoder can be built and benchmarked on a Linux host */
+#ifndef HOSTBENCH_ARDUINO_H
+#define HOSTBENCH_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define PROGMEM
+#define PGM_P const char *
+#define PSTR(string_literal) (string_literal)
+#define ICACHE_RAM_ATTR
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_dword(addr) (*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr) (*(void * const *)(addr))
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+#define strcpy_P strcpy
+#define memcpy_P memcpy
+#define sprintf_P sprintf
+#define snprintf_P snprintf
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper *>(string_literal))
+
+// newlib on the ESP8266 has strlcpy, older glibc does not
+static inline size_t hostbench_strlcpy(char *dst, const char *src, size_t size) {
+  size_t len = strlen(src);
+  if (size > 0) {
+    size_t copy = (len < size) ? len : size - 1;
+    memcpy(dst, src, copy);
+    dst[copy] = '\0';
+  }
+  return len;
+}
+#define strlcpy hostbench_strlcpy
+
+static inline uint16_t word(uint8_t h, uint8_t l) {
+  return (uint16_t)((h << 8) | l);
+}
+
+// the host clock is driven by the benchmark, so replays are deterministic
+extern unsigned long hostbench_millis;
+extern unsigned long hostbench_micros;
+static inline unsigned long millis(void) {
+  return hostbench_millis;
+}
+static inline unsigned long micros(void) {
+  return hostbench_micros;
+}
+static inline void delay(unsigned long ms) {
+  hostbench_millis += ms;
+  hostbench_micros += ms * 1000;
+}
+static inline void yield(void) {}
+
+class String {
+  public:
+    String(const char *cstr = "");
+    String(const String &str);
+    String(const __FlashStringHelper *str);
+    explicit String(char c);
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(float value, unsigned char decimalPlaces = 2);
+    explicit String(double value, unsigned char decimalPlaces = 2);
+    ~String(void);
+
+    String &operator =(const String &rhs);
+    String &operator =(const char *cstr);
+    String &operator +=(const String &rhs);
+    String &operator +=(const char *cstr);
+    String &operator +=(char c);
+    String &operator +=(int value);
+    String &operator +=(unsigned int value);
+    String &operator +=(long value);
+    String &operator +=(unsigned long value);
+    String &operator +=(float value);
+    String &operator +=(double value);
+
+    bool operator ==(const String &rhs) const;
+    bool operator ==(const char *cstr) const;
+    bool operator !=(const String &rhs) const {
+      return !(*this == rhs);
+    }
+    bool operator !=(const char *cstr) const {
+      return !(*this == cstr);
+    }
+
+    unsigned int length(void) const {
+      return len;
+    }
+    const char *c_str(void) const {
+      return buffer ? buffer : "";
+    }
+    bool reserve(unsigned int size);
+    long toInt(void) const;
+    float toFloat(void) const;
+
+  private:
+    char *buffer;
+    unsigned int capacity;
+    unsigned int len;
+    void copy(const char *cstr, unsigned int length);
+    void append(const char *cstr, unsigned int length);
+};
+
+String operator +(const String &lhs, const String &rhs);
+String operator +(const String &lhs, const char *rhs);
+String operator +(const char *lhs, const String &rhs);
+String operator +(const String &lhs, int rhs);
+String operator +(const String &lhs, unsigned int rhs);
+String operator +(const String &lhs, long rhs);
+String operator +(const String &lhs, unsigned long rhs);
+String operator +(const String &lhs, float rhs);
+String operator +(const String &lhs, double rhs);
+
+#endif
@@ -0,0 +1,2 @@
+/* ArduinoJson shim for the host build, the decoder includes it but does not use it */
+#include <Arduino.h>
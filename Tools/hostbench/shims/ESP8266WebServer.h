@@ -0,0 +1,47 @@
+/* ESP8266WebServer shim for the host build, collects the response so the benchmark can report and compare it */
+#ifndef HOSTBENCH_ESP8266WEBSERVER_H
+#define HOSTBENCH_ESP8266WEBSERVER_H
+
+#include <Arduino.h>
+
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+
+#define HOSTBENCH_RESPONSESIZE 32768
+
+class WiFiClient {
+  public:
+    void stop(void) {}
+};
+
+class ESP8266WebServer {
+  public:
+    void setContentLength(size_t length) {}
+    void sendHeader(const char *name, const char *value, bool first = false) {}
+    void send(int code, const char *contentType, const char *content) {
+      length = 0;
+      chunks = 0;
+    }
+    void sendContent(const char *content, size_t size);
+    void sendContent(const char *content) {
+      sendContent(content, strlen(content));
+    }
+    void sendContent(const String &content) {
+      sendContent(content.c_str(), content.length());
+    }
+    void sendContent_P(PGM_P content, size_t size) {
+      sendContent(content, size);
+    }
+    void sendContent_P(PGM_P content) {
+      sendContent(content, strlen(content));
+    }
+    WiFiClient client(void) {
+      return WiFiClient();
+    }
+
+    // response sink, without heap allocations so it does not disturb the measurement
+    char response[HOSTBENCH_RESPONSESIZE];
+    unsigned int length = 0;
+    unsigned int chunks = 0;
+};
+
+#endif
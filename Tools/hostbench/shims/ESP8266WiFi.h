@@ -0,0 +1,2 @@
+/* ESP8266WiFi shim for the host build, only the Arduino core types are needed by the decoder */
+#include <Arduino.h>
@@ -0,0 +1,39 @@
+/* PubSubClient shim for the host build, records every publish so the benchmark can report and compare them */
+#ifndef HOSTBENCH_PUBSUBCLIENT_H
+#define HOSTBENCH_PUBSUBCLIENT_H
+
+#include <Arduino.h>
+
+class PubSubClient {
+  public:
+    PubSubClient(void) {}
+    bool publish(const char *topic, const char *payload, bool retained = false);
+    bool publish(const char *topic, const uint8_t *payload, unsigned int plength, bool retained = false);
+    bool beginPublish(const char *topic, unsigned int plength, bool retained);
+    size_t write(const uint8_t *buffer, size_t size);
+    int endPublish(void);
+    bool subscribe(const char *topic) {
+      return true;
+    }
+    bool unsubscribe(const char *topic) {
+      return true;
+    }
+    bool connected(void) {
+      return true;
+    }
+
+    // publish sink, set by the benchmark
+    void (*onPublish)(const char *topic, const char *payload, unsigned int plength, bool retained) = 0;
+    unsigned long publishes = 0;
+    unsigned long publishedBytes = 0;
+
+  private:
+    // a streamed publish is collected here and handed to onPublish at endPublish, a fixed buffer so it is not counted as an allocation
+    char streamTopic[256];
+    char streamPayload[8192];
+    unsigned int streamLength = 0;
+    unsigned int streamExpected = 0;
+    bool streamRetained = false;
+};
+
+#endif
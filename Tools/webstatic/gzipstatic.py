@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+# Gzips the static web files in this directory into PROGMEM arrays in HeishaMon/webstatic.h
+#
+#   python3 gzipstatic.py          regenerate HeishaMon/webstatic.h
+#   python3 gzipstatic.py --check  fail when HeishaMon/webstatic.h is not up to date
+#
+# The url of each file carries a hash of its content, so the pages can let the browser cache it forever.
+
+import gzip
+import hashlib
+import os
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+OUTPUT = os.path.join(HERE, '..', '..', 'HeishaMon', 'webstatic.h')
+
+# file, content type, define of its url
+FILES = [
+    ('heishamon.js', 'application/javascript', 'WEBSTATIC_JS_URL'),
+]
+
+
+def identifier(name):
+    base, ext = name.split('.')
+    return 'webStatic' + base.capitalize() + ext.capitalize()
+
+
+def generate():
+    lines = [
+        '// Generated by Tools/webstatic/gzipstatic.py from Tools/webstatic, do not edit',
+        '#ifndef WEBSTATIC_H',
+        '#define WEBSTATIC_H',
+        '',
+    ]
+    table = []
+    for name, content_type, define in FILES:
+        with open(os.path.join(HERE, name), 'rb') as f:
+            data = f.read()
+        packed = gzip.compress(data, 9, mtime=0)
+        version = hashlib.sha1(data).hexdigest()[:8]
+        lines.append('#define %s "/%s?v=%s"' % (define, name, version))
+        lines.append('// %s: %u bytes, %u bytes gzipped' % (name, len(data), len(packed)))
+        lines.append('static const uint8_t %s[] PROGMEM = {' % identifier(name))
+        for i in range(0, len(packed), 16):
+            lines.append('  ' + ', '.join('0x%02x' % b for b in packed[i:i + 16]) + ',')
+        lines.append('};')
+        lines.append('')
+        table.append('  { "/%s", "%s", "%s", %s, sizeof(%s) },' % (name, content_type, version, identifier(name), identifier(name)))
+    lines += [
+        'struct webStaticStruct {',
+        '  const char *path;',
+        '  const char *contentType;',
+        '  const char *version;  // hash of the content, the v argument of the url',
+        '  const uint8_t *data;',
+        '  unsigned int length;',
+        '};',
+        '',
+        '#define NUMBER_OF_WEB_STATIC %u' % len(FILES),
+        'static const webStaticStruct webStatic[NUMBER_OF_WEB_STATIC] = {',
+    ] + table + [
+        '};',
+        '',
+        '#endif',
+        '',
+    ]
+    return '\n'.join(lines)
+
+
+def main():
+    header = generate()
+    if '--check' in sys.argv:
+        with open(OUTPUT) as f:
+            if f.read() != header:
+                sys.exit('HeishaMon/webstatic.h is out of date, run Tools/webstatic/gzipstatic.py')
+        print('webstatic.h is up to date')
+        return
+    with open(OUTPUT, 'w') as f:
+        f.write(header)
+
+
+if __name__ == '__main__':
+    main()
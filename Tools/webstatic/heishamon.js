@@ -0,0 +1,62 @@
+// Scripts of the HeishaMon web pages. Gzip this into HeishaMon/webstatic.h with gzipstatic.py after a change.
+
+function openLeftMenu() {
+  var x = document.getElementById("leftMenu");
+  if (x.style.display === "none") {
+    x.style.display = "block";
+  } else {
+    x.style.display = "none";
+  }
+}
+
+// root page: the value tables
+var live = false, timer = 0;
+function refreshTable() {
+  clearTimeout(timer);
+  $('#heishavalues').load('/tablerefresh', function() {if (!live) timer = setTimeout(refreshTable, 30000);});
+  $('#dallasvalues').load('/tablerefresh?1wire', function() {});
+  $('#s0values').load('/tablerefresh?s0', function() {});
+}
+function openSocket() {
+  if (!window.WebSocket) return;
+  var socket = new WebSocket('ws://' + location.hostname + ':81/');
+  socket.onopen = function() {live = true; refreshTable();};
+  socket.onclose = function() {if (live) {live = false; refreshTable();} setTimeout(openSocket, 30000);};
+  socket.onmessage = function(event) {
+    var values = JSON.parse(event.data);
+    if (values.reload) {$(values.reload == '1wire' ? '#dallasvalues' : '#s0values').load('/tablerefresh?' + values.reload); return;}
+    for (var i = 0; i < values.length; i++) {
+      var row = document.getElementById('TOP' + values[i][0]);
+      if (row) {row.cells[2].innerHTML = values[i][1]; row.cells[3].innerHTML = values[i][2];}
+    }
+  };
+}
+function openTable(tableName) {
+  var i;
+  var x = document.getElementsByClassName("heishatable");
+  for (i = 0; i < x.length; i++) {
+    x[i].style.display = "none";
+  }
+  document.getElementById(tableName).style.display = "block";
+}
+
+// settings page
+function ShowHideDallasTable(dallasEnabled) {
+  var dallassettings = document.getElementById("dallassettings");
+  dallassettings.style.display = dallasEnabled.checked ? "table" : "none";
+}
+function ShowHideS0Table(s0enabled) {
+  var s0settings = document.getElementById("s0settings");
+  s0settings.style.display = s0enabled.checked ? "table" : "none";
+}
+function changeMinWatt(port) {
+  var ppkwh = document.getElementById('s0_ppkwh_'+port).value;
+  var interval = document.getElementById('s0_interval_'+port).value;
+  document.getElementById('s0_minwatt_'+port).innerHTML = Math.round((3600 * 1000 / ppkwh) / interval);
+}
+
+// the script is deferred, so the page is parsed (and jquery loaded on the root page) when this runs
+if (document.getElementById('heishavalues')) {
+  refreshTable();
+  openSocket();
+}